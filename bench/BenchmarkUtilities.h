@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Helpers shared by the benchmarks in this directory
+namespace bench {
+    constexpr int RUNS = 5;
+
+    inline auto readFile(const std::filesystem::path &path) -> std::string {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file " + path.string());
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    // Source files given on the command line from firstArgument on, ../resources/*.pc if there are none
+    inline auto collectSources(const int argc, char *argv[], const int firstArgument)
+            -> std::vector<std::filesystem::path> {
+        std::vector<std::filesystem::path> paths;
+        for (int i = firstArgument; i < argc; ++i) {
+            paths.emplace_back(argv[i]);
+        }
+        if (paths.empty()) {
+            for (const auto &entry : std::filesystem::directory_iterator("../resources")) {
+                if (entry.path().extension() == ".pc") {
+                    paths.push_back(entry.path());
+                }
+            }
+        }
+        std::ranges::sort(paths);
+        return paths;
+    }
+
+    // Drops the program header so the declarations of several sources can be concatenated
+    inline auto stripProgramHeader(std::string source) -> std::string {
+        if (const std::size_t keyword = source.find("program"); keyword != std::string::npos) {
+            source.erase(keyword, source.find(';', keyword) + 1 - keyword);
+        }
+        return source;
+    }
+
+    // The declarations of the sources repeated under a single program header until the input reaches targetBytes
+    inline auto makeProgram(const std::vector<std::filesystem::path> &paths, const std::size_t targetBytes)
+            -> std::string {
+        std::string seed;
+        for (const auto &path : paths) {
+            seed += stripProgramHeader(readFile(path)) + '\n';
+        }
+
+        std::string input = "program benchmark;\n";
+        input.reserve(targetBytes + seed.size());
+        while (input.size() < targetBytes) {
+            input += seed;
+        }
+        return input;
+    }
+
+    // Runs the callable RUNS times and returns the best throughput in MB/s
+    template <typename Function>
+    auto measure(const std::size_t bytes, Function &&function) -> double {
+        double bestSeconds = 0.0;
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            bestSeconds = run == 0 ? elapsed.count() : std::min(bestSeconds, elapsed.count());
+        }
+        return static_cast<double>(bytes) / (1024.0 * 1024.0) / bestSeconds;
+    }
+} // namespace bench
@@ -0,0 +1,157 @@
+// Parser throughput benchmark on a large synthetic program, serial and with parallel function parsing.
+// Also counts heap allocations per token and reports the memory of the arena allocated AST, and compares it with the
+// flat AST layout: memory, conversion and a whole-tree walk. Last, the AST is cached in a .pcast file and loading it
+// is compared with lexing and parsing the source.
+//
+// usage: parser_benchmark [megabytes] [source files...]
+// The declarations of the given sources (default: ../resources/*.pc) are repeated under a single program header
+// until the input reaches the requested size.
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "../include/AstWalker.h"
+#include "../include/FlatAst.h"
+#include "../include/Parser.h"
+#include "../include/SourceBuffer.h"
+#include "../include/StringInterner.h"
+#include "../include/Tokenizer.h"
+#include "BenchmarkUtilities.h"
+
+namespace {
+    std::size_t allocations = 0;
+} // namespace
+
+auto operator new(const std::size_t size) -> void * {
+    ++allocations;
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+int main(int argc, char *argv[]) {
+    const std::size_t targetBytes = (argc > 1 ? std::stoul(argv[1]) : 16) * 1024 * 1024;
+
+    const std::string input = bench::makeProgram(bench::collectSources(argc, argv, 2), targetBytes);
+
+    const SourceBuffer source = SourceBuffer::fromMemory(input, "benchmark");
+    StringInterner     interner;
+    const TokenStore   tokens = Tokenizer(source, interner).tokenize();
+
+    // token access alone, through the same stream interface the parser reads from
+    std::size_t allocationsBefore = allocations;
+    {
+        TokenStoreStream stream(tokens);
+        while (stream.peek().getKind() != TokenKind::EndOfFile) {
+            if (stream.peek(1).getKind() == TokenKind::EndOfFile) {
+                break;
+            }
+            stream.next();
+        }
+    }
+    const std::size_t cursorAllocations = allocations - allocationsBefore;
+
+    allocationsBefore = allocations;
+    AstStatistics statistics;
+    {
+        Parser parser;
+        statistics = parser.parse(tokens)->getStatistics();
+    }
+    const std::size_t parseAllocations = allocations - allocationsBefore;
+
+    const double parseThroughput = bench::measure(input.size(), [&] {
+        Parser parser;
+        parser.parse(tokens);
+    });
+    std::size_t  parallelArenas = 0;
+    const double parallelThroughput = bench::measure(input.size(), [&] {
+        Parser parser;
+        parallelArenas = parser.parseParallel(tokens)->arenas.size();
+    });
+    const double streamingThroughput = bench::measure(input.size(), [&] {
+        StringInterner streamingInterner;
+        Tokenizer      tokenizer(source, streamingInterner);
+        Parser         parser;
+        parser.parse(tokenizer);
+    });
+
+    // whole-tree walk summing the integer literals: the pointer tree on an AstWalker, the flat one as a scan
+    const std::unique_ptr<Program> program = Parser().parse(tokens);
+    const double flattenThroughput = bench::measure(input.size(), [&] { FlatAst::fromProgram(*program); });
+    const FlatAst flat = FlatAst::fromProgram(*program);
+
+    std::int64_t pointerSum = 0;
+    std::int64_t flatSum = 0;
+    const double pointerWalkThroughput = bench::measure(input.size(), [&] {
+        AstWalker walker;
+        pointerSum = 0;
+        walker.walk(
+                *program,
+                [&](const AbstractNode &node, const AbstractNode *, std::size_t) {
+                    if (node.getKind() == NodeKind::Literal &&
+                        static_cast<const Literal &>(node).literalKind == LiteralKind::Integer) {
+                        pointerSum += static_cast<const Literal &>(node).number.integer;
+                    }
+                    return true;
+                },
+                [](const AbstractNode &, const AbstractNode *) {});
+    });
+    const double flatWalkThroughput = bench::measure(input.size(), [&] {
+        flatSum = 0;
+        for (FlatNodeId id = 0; id < flat.size(); ++id) {
+            if (flat.getKind(id) == NodeKind::Literal && flat.get<FlatLiteral>(id).literalKind == LiteralKind::Integer) {
+                flatSum += flat.get<FlatLiteral>(id).number.integer;
+            }
+        }
+    });
+    if (pointerSum != flatSum) {
+        std::cerr << "flat walk disagrees with the pointer walk\n";
+        return 1;
+    }
+
+    // the cached AST against lexing and parsing, both end in a Program from the source or the file
+    const std::string cachePath = (std::filesystem::temp_directory_path() / "parser_benchmark.pcast").string();
+    const double      saveThroughput = bench::measure(input.size(), [&] { flat.save(cachePath); });
+    const double      loadThroughput = bench::measure(input.size(), [&] {
+        StringInterner loadInterner;
+        FlatAst::load(cachePath, loadInterner);
+    });
+    const double      loadProgramThroughput = bench::measure(input.size(), [&] {
+        StringInterner                 loadInterner;
+        const std::unique_ptr<Program> loaded = FlatAst::load(cachePath, loadInterner).toProgram();
+    });
+    const std::uintmax_t cacheBytes = std::filesystem::file_size(cachePath);
+    std::filesystem::remove(cachePath);
+
+    const auto perToken = [&](const std::size_t count) {
+        return static_cast<double>(count) / static_cast<double>(tokens.size());
+    };
+
+    std::cout << "input:        " << input.size() / (1024 * 1024) << " MB, " << tokens.size() << " tokens\n";
+    std::cout << "parse:        " << parseThroughput << " MB/s (from a TokenStore)\n";
+    std::cout << "parallel:     " << parallelThroughput << " MB/s (" << std::thread::hardware_concurrency()
+              << " threads, " << parallelArenas - 1 << " workers, " << parallelThroughput / parseThroughput
+              << "x over serial)\n";
+    std::cout << "lex + parse:  " << streamingThroughput << " MB/s (streaming)\n";
+    std::cout << "allocations:  " << perToken(cursorAllocations) << " per token for token access, "
+              << perToken(parseAllocations) << " per token for the whole parse (arena slabs)\n";
+    statistics.print(std::cout);
+    std::cout << "flatten:      " << flattenThroughput << " MB/s\n";
+    std::cout << "walk:         " << pointerWalkThroughput << " MB/s pointer tree, " << flatWalkThroughput
+              << " MB/s flat (" << flatWalkThroughput / pointerWalkThroughput << "x)\n";
+    std::cout << "flat ";
+    flat.getStatistics().print(std::cout);
+    std::cout << "pcast:        " << cacheBytes / (1024 * 1024) << " MB file, save " << saveThroughput << " MB/s, load "
+              << loadThroughput << " MB/s to a FlatAst, " << loadProgramThroughput << " MB/s to a Program ("
+              << loadProgramThroughput / streamingThroughput << "x over lex + parse)\n";
+    return 0;
+}
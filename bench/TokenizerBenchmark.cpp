@@ -0,0 +1,214 @@
+// Lexer throughput benchmark: table-driven Tokenizer against the previous std::set based implementation,
+// and the parallel mode of the Tokenizer against the serial one
+//
+// usage: tokenizer_benchmark [megabytes] [source files...]
+// The given sources (default: ../resources/*.pc) are repeated until the input reaches the requested size.
+
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/Scanner.h"
+#include "../include/SourceBuffer.h"
+#include "../include/Tokenizer.h"
+#include "BenchmarkUtilities.h"
+
+namespace {
+    // Previous Tokenizer core, kept verbatim apart from returning plain strings, as the baseline
+    namespace legacy {
+        const std::set<std::string> KEYWORDS = {"if",       "else",   "while",   "return", "break",
+                                                "continue", "import", "program", "func"};
+
+        const std::set<char> SYMBOLS = {'+', '-', '*', '/', '=', '!', '<', '>', '(', ')', '{', '}',
+                                        '[', ']', ';', ',', '.', ':', '&', '|', '^', '~', '.', '%',
+                                        '?', '@', '#', '$', '\\', '`'};
+
+        const std::set<std::string> LONG_SYMBOLS = {"==", "!=", "<=", ">=", "&&", "||",
+                                                    "->", "<<", ">>", "++", "--"};
+
+        const std::set<char> WHITESPACE = {' ', '\t', '\n', '\r', '\0'};
+
+        struct Token {
+            std::string  value;
+            TokenType    type;
+            unsigned int line;
+            unsigned int column;
+        };
+
+        class Tokenizer {
+        public:
+            explicit Tokenizer(std::string source) : m_source(std::move(source)) {}
+
+            auto tokenize() -> std::vector<Token> {
+                m_max_index = m_source.size();
+                while (m_current_index < m_max_index) {
+                    const char currentChar = m_source[m_current_index];
+                    if (WHITESPACE.contains(currentChar)) {
+                        handleWhiteSpace();
+                    } else if (isalpha(currentChar) || currentChar == '_') {
+                        handleIdentifierOrKeyword();
+                    } else if (isdigit(currentChar)) {
+                        handleNumber();
+                    } else if (currentChar == '"' || currentChar == '\'') {
+                        handleStringOrChar();
+                    } else if (SYMBOLS.contains(currentChar)) {
+                        handleSymbol();
+                    } else {
+                        throw std::runtime_error("legacy tokenizer: invalid character");
+                    }
+                }
+                return m_tokens;
+            }
+
+        private:
+            std::string        m_source;
+            std::vector<Token> m_tokens;
+            std::size_t        m_max_index = 0;
+            std::size_t        m_current_index = 0;
+            unsigned int       m_line = 1;
+            unsigned int       m_column = 1;
+
+            void handleWhiteSpace() {
+                while (m_current_index < m_max_index && WHITESPACE.contains(m_source[m_current_index])) {
+                    if (m_source[m_current_index] == '\n') {
+                        m_line++;
+                        m_column = 1;
+                    } else {
+                        m_column++;
+                    }
+                    m_current_index++;
+                }
+            }
+
+            void handleSymbol() {
+                if (m_current_index + 1 < m_max_index) {
+                    const std::string symbol = m_source.substr(m_current_index, 2);
+                    if (symbol == "//") {
+                        while (m_current_index < m_max_index && m_source[m_current_index] != '\n') {
+                            advance();
+                        }
+                        return;
+                    }
+                    if (LONG_SYMBOLS.contains(symbol)) {
+                        addToken(TokenType::Symbol, symbol);
+                        advance();
+                        advance();
+                        return;
+                    }
+                }
+                addToken(TokenType::Symbol, std::string(1, m_source[m_current_index]));
+                advance();
+            }
+
+            void handleStringOrChar() {
+                std::string value;
+                const char  quote = m_source[m_current_index];
+                advance();
+                while (m_current_index < m_max_index && m_source[m_current_index] != quote) {
+                    value += m_source[m_current_index];
+                    advance();
+                }
+                advance();
+                addToken(quote == '"' ? TokenType::String : TokenType::Char, value);
+            }
+
+            void handleNumber() {
+                std::string number;
+                bool        isFloat = false;
+                while (m_current_index < m_max_index &&
+                       (isdigit(m_source[m_current_index]) || m_source[m_current_index] == '.')) {
+                    isFloat = isFloat || m_source[m_current_index] == '.';
+                    number += m_source[m_current_index];
+                    advance();
+                }
+                addToken(isFloat ? TokenType::Float : TokenType::Integer, number);
+            }
+
+            void handleIdentifierOrKeyword() {
+                std::string identifier;
+                while (m_current_index < m_max_index &&
+                       (isalnum(m_source[m_current_index]) || m_source[m_current_index] == '_')) {
+                    identifier += m_source[m_current_index];
+                    advance();
+                }
+                addToken(KEYWORDS.contains(identifier) ? TokenType::Keyword : TokenType::Identifier, identifier);
+            }
+
+            void advance() {
+                if (m_current_index >= m_max_index) {
+                    throw std::runtime_error("legacy tokenizer: cannot advance past end of source");
+                }
+                m_current_index++;
+                m_column++;
+            }
+
+            void addToken(const TokenType type, const std::string &value) {
+                m_tokens.push_back(Token{value, type, m_line, m_column});
+            }
+        };
+    } // namespace legacy
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const std::size_t targetBytes = (argc > 1 ? std::stoul(argv[1]) : 16) * 1024 * 1024;
+
+    std::string seed;
+    for (const auto &path : bench::collectSources(argc, argv, 2)) {
+        seed += bench::readFile(path) + '\n';
+    }
+    if (seed.empty()) {
+        std::cerr << "No input sources found\n";
+        return 1;
+    }
+
+    std::string input;
+    input.reserve(targetBytes + seed.size());
+    while (input.size() < targetBytes) {
+        input += seed;
+    }
+
+    const SourceBuffer source = SourceBuffer::fromMemory(input, "benchmark");
+
+    std::size_t tokenCount = 0;
+    std::size_t legacyTokenCount = 0;
+    std::size_t parallelTokenCount = 0;
+
+    const double legacyThroughput = bench::measure(input.size(), [&] {
+        legacy::Tokenizer tokenizer(input);
+        legacyTokenCount = tokenizer.tokenize().size();
+    });
+    const double throughput = bench::measure(input.size(), [&] {
+        StringInterner interner;
+        Tokenizer      tokenizer(source, interner);
+        tokenCount = tokenizer.tokenize().size();
+    });
+    const double parallelThroughput = bench::measure(input.size(), [&] {
+        StringInterner interner;
+        Tokenizer      tokenizer(source, interner);
+        parallelTokenCount = tokenizer.tokenizeParallel().size();
+    });
+
+    if (tokenCount != legacyTokenCount || tokenCount != parallelTokenCount) {
+        std::cerr << "Token count mismatch: " << tokenCount << " vs " << legacyTokenCount << " (legacy) vs "
+                  << parallelTokenCount << " (parallel)\n";
+        return 1;
+    }
+
+    // memory of the stored tokens, the figure the 8-byte target was set for
+    StringInterner    storeInterner;
+    const TokenStore  store = Tokenizer(source, storeInterner).tokenize();
+    const std::size_t bytes = store.getUsedBytes();
+
+    std::cout << "input:        " << input.size() / (1024 * 1024) << " MB, " << tokenCount << " tokens\n";
+    std::cout << "token store:  " << TokenStore::BYTES_PER_TOKEN << " bytes per token (target: under 8), "
+              << static_cast<double>(bytes) / static_cast<double>(store.size()) << " with number entries\n";
+    std::cout << "legacy:       " << legacyThroughput << " MB/s\n";
+    std::cout << "table-driven: " << throughput << " MB/s (" << scanner::instructionSet() << " scanners)\n";
+    std::cout << "speedup:      " << throughput / legacyThroughput << "x\n";
+    std::cout << "parallel:     " << parallelThroughput << " MB/s (" << std::thread::hardware_concurrency()
+              << " threads, " << parallelThroughput / throughput << "x over serial)\n";
+    return 0;
+}
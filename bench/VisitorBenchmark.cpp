@@ -0,0 +1,237 @@
+// Full-tree walks with the virtual Visitor against the statically dispatched RecursiveVisitor.
+// Every walk counts the nodes and sums the integer literals of a large synthetic program:
+//  - virtual, recursive: each visit calls accept on its children, two indirect calls and a native frame per node
+//  - virtual, AstWalker: the explicit stack of the AstWalker, accept and visit are still two indirect calls per node
+//  - RecursiveVisitor:   native recursion with one switch over the kind tag per node, hooks and child lists inlined
+// It also times StructuralHashes::compute on the resolved program, a RecursiveVisitor that hashes every node and
+// indexes the expressions.
+//
+// usage: visitor_benchmark [megabytes] [source files...]
+// The declarations of the given sources (default: ../resources/*.pc) are repeated under a single program header
+// until the input reaches the requested size.
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "../include/AstWalker.h"
+#include "../include/Parser.h"
+#include "../include/RecursiveVisitor.h"
+#include "../include/Resolver.h"
+#include "../include/SourceBuffer.h"
+#include "../include/StringInterner.h"
+#include "../include/StructuralHash.h"
+#include "../include/Tokenizer.h"
+#include "BenchmarkUtilities.h"
+
+namespace {
+    // What every walk computes, the walks have to agree on it
+    struct Summary {
+        std::size_t  nodes = 0;
+        std::int64_t integers = 0;
+
+        auto operator==(const Summary &) const -> bool = default;
+
+        void addLiteral(const Literal &node) {
+            if (node.literalKind == LiteralKind::Integer) {
+                integers += node.number.integer;
+            }
+        }
+    };
+
+    // Visits a node and its children through accept, the way Visitor passes walk a tree
+    class RecursiveSummaryVisitor final : public Visitor {
+    public:
+        Summary summary;
+
+        void visit(Block &node) override {
+            summary.nodes++;
+            for (AbstractNode *statement : node.statements) {
+                statement->accept(*this);
+            }
+        }
+        void visit(Program &node) override {
+            summary.nodes++;
+            node.body->accept(*this);
+        }
+        void visit(FunctionDeclaration &node) override {
+            summary.nodes++;
+            node.body->accept(*this);
+        }
+        void visit(FunctionCall &node) override {
+            summary.nodes++;
+            for (AbstractNode *argument : node.arguments) {
+                argument->accept(*this);
+            }
+        }
+        void visit(VariableDeclaration &node) override {
+            summary.nodes++;
+            acceptIfPresent(node.initializer);
+        }
+        void visit(Literal &node) override {
+            summary.nodes++;
+            summary.addLiteral(node);
+        }
+        void visit(Reference &) override { summary.nodes++; }
+        void visit(BinaryOperation &node) override {
+            summary.nodes++;
+            node.left->accept(*this);
+            node.right->accept(*this);
+        }
+        void visit(UnaryOperation &node) override {
+            summary.nodes++;
+            node.operand->accept(*this);
+        }
+        void visit(IfStatement &node) override {
+            summary.nodes++;
+            node.condition->accept(*this);
+            node.thenBranch->accept(*this);
+            acceptIfPresent(node.elseBranch);
+        }
+        void visit(WhileLoop &node) override {
+            summary.nodes++;
+            node.condition->accept(*this);
+            node.body->accept(*this);
+        }
+        void visit(ReturnStatement &node) override {
+            summary.nodes++;
+            acceptIfPresent(node.expression);
+        }
+        void visit(ExpressionStatement &node) override {
+            summary.nodes++;
+            node.expression->accept(*this);
+        }
+        void visit(Assignment &node) override {
+            summary.nodes++;
+            node.value->accept(*this);
+        }
+        void visit(ErrorNode &) override { summary.nodes++; }
+
+    private:
+        void acceptIfPresent(AbstractNode *node) {
+            if (node != nullptr) {
+                node->accept(*this);
+            }
+        }
+    };
+
+    // Visits a single node, the AstWalker does the walking
+    class NodeSummaryVisitor final : public Visitor {
+    public:
+        Summary summary;
+
+        void visit(Block &) override { summary.nodes++; }
+        void visit(Program &) override { summary.nodes++; }
+        void visit(FunctionDeclaration &) override { summary.nodes++; }
+        void visit(FunctionCall &) override { summary.nodes++; }
+        void visit(VariableDeclaration &) override { summary.nodes++; }
+        void visit(Literal &node) override {
+            summary.nodes++;
+            summary.addLiteral(node);
+        }
+        void visit(Reference &) override { summary.nodes++; }
+        void visit(BinaryOperation &) override { summary.nodes++; }
+        void visit(UnaryOperation &) override { summary.nodes++; }
+        void visit(IfStatement &) override { summary.nodes++; }
+        void visit(WhileLoop &) override { summary.nodes++; }
+        void visit(ReturnStatement &) override { summary.nodes++; }
+        void visit(ExpressionStatement &) override { summary.nodes++; }
+        void visit(Assignment &) override { summary.nodes++; }
+        void visit(ErrorNode &) override { summary.nodes++; }
+    };
+
+    // Counts every node before its children, like the Visitor based walks
+    class StaticSummaryVisitor final : public RecursiveVisitor<StaticSummaryVisitor> {
+    public:
+        Summary summary;
+
+        auto visitProgram(Program &) -> bool { return count(); }
+        auto visitBlock(Block &) -> bool { return count(); }
+        auto visitFunctionDeclaration(FunctionDeclaration &) -> bool { return count(); }
+        auto visitFunctionCall(FunctionCall &) -> bool { return count(); }
+        auto visitVariableDeclaration(VariableDeclaration &) -> bool { return count(); }
+        auto visitLiteral(Literal &node) -> bool {
+            summary.addLiteral(node);
+            return count();
+        }
+        auto visitReference(Reference &) -> bool { return count(); }
+        auto visitBinaryOperation(BinaryOperation &) -> bool { return count(); }
+        auto visitUnaryOperation(UnaryOperation &) -> bool { return count(); }
+        auto visitIfStatement(IfStatement &) -> bool { return count(); }
+        auto visitWhileLoop(WhileLoop &) -> bool { return count(); }
+        auto visitReturnStatement(ReturnStatement &) -> bool { return count(); }
+        auto visitExpressionStatement(ExpressionStatement &) -> bool { return count(); }
+        auto visitAssignment(Assignment &) -> bool { return count(); }
+        auto visitError(ErrorNode &) -> bool { return count(); }
+
+    private:
+        auto count() -> bool {
+            summary.nodes++;
+            return true;
+        }
+    };
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const std::size_t targetBytes = (argc > 1 ? std::stoul(argv[1]) : 16) * 1024 * 1024;
+    const std::string input = bench::makeProgram(bench::collectSources(argc, argv, 2), targetBytes);
+
+    const SourceBuffer             source = SourceBuffer::fromMemory(input, "benchmark");
+    StringInterner                 interner;
+    const TokenStore               tokens = Tokenizer(source, interner).tokenize();
+    const std::unique_ptr<Program> program = Parser().parse(tokens);
+    Resolver::resolve(*program); // canonical expressions go by the declarations names are bound to
+
+    Summary      recursiveSummary;
+    const double recursiveThroughput = bench::measure(input.size(), [&] {
+        RecursiveSummaryVisitor visitor;
+        program->accept(visitor);
+        recursiveSummary = visitor.summary;
+    });
+
+    Summary      walkerSummary;
+    const double walkerThroughput = bench::measure(input.size(), [&] {
+        NodeSummaryVisitor visitor;
+        AstWalker          walker;
+        walker.walk(
+                *program,
+                [&](AbstractNode &node, AbstractNode *, std::size_t) {
+                    node.accept(visitor);
+                    return true;
+                },
+                [](AbstractNode &, AbstractNode *) {});
+        walkerSummary = visitor.summary;
+    });
+
+    Summary      staticSummary;
+    const double staticThroughput = bench::measure(input.size(), [&] {
+        StaticSummaryVisitor visitor;
+        visitor.traverse(*program);
+        staticSummary = visitor.summary;
+    });
+
+    StructuralHashes hashes;
+    const double     hashThroughput =
+            bench::measure(input.size(), [&] { hashes = StructuralHashes::compute(*program); });
+
+    if (recursiveSummary != walkerSummary || recursiveSummary != staticSummary) {
+        std::cerr << "the walks disagree\n";
+        return 1;
+    }
+
+    const auto nodesPerSecond = [&](const double throughput) {
+        return static_cast<double>(recursiveSummary.nodes) * throughput * 1024.0 * 1024.0 /
+               static_cast<double>(input.size()) / 1e6;
+    };
+    std::cout << "input:              " << input.size() / (1024 * 1024) << " MB, " << recursiveSummary.nodes
+              << " nodes\n";
+    std::cout << "virtual, recursive: " << nodesPerSecond(recursiveThroughput) << " M nodes/s\n";
+    std::cout << "virtual, AstWalker: " << nodesPerSecond(walkerThroughput) << " M nodes/s\n";
+    std::cout << "RecursiveVisitor:   " << nodesPerSecond(staticThroughput) << " M nodes/s ("
+              << staticThroughput / recursiveThroughput << "x over recursive, " << staticThroughput / walkerThroughput
+              << "x over AstWalker)\n";
+    std::cout << "structural hashes:  " << nodesPerSecond(hashThroughput) << " M nodes/s ("
+              << hashes.getFunctions().size() << " functions, " << hashes.getExpressionCount() << " expressions, "
+              << hashes.getDistinctExpressionCount() << " distinct)\n";
+    return 0;
+}
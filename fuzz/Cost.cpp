@@ -0,0 +1,133 @@
+#include "Cost.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <linux/perf_event.h>
+#include <new>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    std::atomic<std::uint64_t> liveBytes = 0;
+    std::atomic<std::uint64_t> peakBytes = 0;
+
+    // Allocations carry their size in front of the block so delete can account for them
+    constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+    constexpr std::size_t BUCKETS = 32;
+
+    // Coverage counters libFuzzer picks up from this section next to its own instrumentation
+    __attribute__((section("__libfuzzer_extra_counters"))) std::uint8_t costCounters[2 * BUCKETS];
+
+    // Logarithmic bucket with two steps per power of two
+    auto bucketOf(const double value) -> std::size_t {
+        const auto integral = static_cast<std::uint64_t>(std::max(value, 1.0));
+        const auto exponent = static_cast<std::size_t>(std::bit_width(integral) - 1);
+        const bool upperHalf = exponent > 0 && (integral >> (exponent - 1) & 1) != 0;
+        return std::min(BUCKETS - 1, 2 * exponent + (upperHalf ? 1 : 0));
+    }
+
+    auto budget(const char *variable) -> double {
+        const char *value = std::getenv(variable);
+        return value == nullptr ? 0.0 : std::strtod(value, nullptr);
+    }
+
+    auto threadCpuNanoseconds() -> std::uint64_t {
+        timespec time{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return static_cast<std::uint64_t>(time.tv_sec) * 1'000'000'000 + static_cast<std::uint64_t>(time.tv_nsec);
+    }
+} // namespace
+
+auto operator new(const std::size_t size) -> void * {
+    auto *block = static_cast<std::byte *>(std::malloc(size + HEADER_SIZE));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<std::size_t *>(block) = size;
+
+    const std::uint64_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::uint64_t       peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return block + HEADER_SIZE;
+}
+
+void operator delete(void *memory) noexcept {
+    if (memory == nullptr) {
+        return;
+    }
+    auto *block = static_cast<std::byte *>(memory) - HEADER_SIZE;
+    liveBytes.fetch_sub(*reinterpret_cast<std::size_t *>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void *memory, std::size_t) noexcept { operator delete(memory); }
+
+CostMeter::CostMeter() {
+    perf_event_attr attributes{};
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    m_counter = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+CostMeter::~CostMeter() {
+    if (m_counter >= 0) {
+        close(m_counter);
+    }
+}
+
+auto CostMeter::measure(void (*target)(std::string_view), const std::string_view input) -> Cost {
+    const std::uint64_t baseline = liveBytes.load(std::memory_order_relaxed);
+    peakBytes.store(baseline, std::memory_order_relaxed);
+
+    Cost cost;
+    if (countsInstructions()) {
+        ioctl(m_counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_counter, PERF_EVENT_IOC_ENABLE, 0);
+        target(input);
+        ioctl(m_counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(m_counter, &cost.work, sizeof(cost.work)) != sizeof(cost.work)) {
+            cost.work = 0;
+        }
+    } else {
+        const std::uint64_t start = threadCpuNanoseconds();
+        target(input);
+        cost.work = threadCpuNanoseconds() - start;
+    }
+
+    cost.peakBytes = peakBytes.load(std::memory_order_relaxed) - baseline;
+    return cost;
+}
+
+void reportCost(const Cost &cost, const std::size_t inputSize) {
+    // a fixed allowance keeps the constant setup cost from dominating tiny inputs
+    const double bytes = static_cast<double>(inputSize) + 64.0;
+    const double workPerByte = static_cast<double>(cost.work) / bytes;
+    const double heapPerByte = static_cast<double>(cost.peakBytes) / bytes;
+
+    costCounters[bucketOf(workPerByte)] = 1;
+    costCounters[BUCKETS + bucketOf(heapPerByte)] = 1;
+
+    static const double maxWorkPerByte = budget("PCORE_FUZZ_MAX_WORK_PER_BYTE");
+    static const double maxHeapPerByte = budget("PCORE_FUZZ_MAX_HEAP_PER_BYTE");
+    if (maxWorkPerByte > 0.0 && workPerByte > maxWorkPerByte) {
+        std::fprintf(stderr, "pcore fuzz: %.1f work per byte exceeds the budget of %.1f\n", workPerByte,
+                     maxWorkPerByte);
+        std::abort();
+    }
+    if (maxHeapPerByte > 0.0 && heapPerByte > maxHeapPerByte) {
+        std::fprintf(stderr, "pcore fuzz: %.1f heap bytes per byte exceeds the budget of %.1f\n", heapPerByte,
+                     maxHeapPerByte);
+        std::abort();
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Cost of a single run of a fuzz target
+struct Cost {
+    std::uint64_t work = 0;      // retired user space instructions, CPU nanoseconds without hardware counters
+    std::uint64_t peakBytes = 0; // peak of the live heap bytes above the level at the start of the run
+};
+
+// Measures targets with the instruction counter of perf_event_open, falling back to the thread CPU clock where the
+// kernel does not allow it. Heap usage is tracked by the replacement operator new of this module.
+class CostMeter {
+public:
+    CostMeter();
+    ~CostMeter();
+    CostMeter(const CostMeter &) = delete;
+    CostMeter &operator=(const CostMeter &) = delete;
+
+    auto measure(void (*target)(std::string_view), std::string_view input) -> Cost;
+
+    [[nodiscard]] auto countsInstructions() const -> bool;
+
+private:
+    int m_counter = -1; // perf event file descriptor
+};
+
+// Hands the cost per input byte to libFuzzer as extra coverage counters, so an input reaching a higher cost bucket
+// is new coverage and kept in the corpus, which drifts towards expensive inputs. If PCORE_FUZZ_MAX_WORK_PER_BYTE or
+// PCORE_FUZZ_MAX_HEAP_PER_BYTE is set and exceeded the run aborts, so libFuzzer saves the input as a crash and
+// -minimize_crash=1 shrinks it while it stays over budget.
+void reportCost(const Cost &cost, std::size_t inputSize);
+
+inline auto CostMeter::countsInstructions() const -> bool { return m_counter >= 0; }
@@ -0,0 +1,24 @@
+#include "FuzzTargets.h"
+
+#include "../include/Diagnostics.h"
+#include "../include/Parser.h"
+#include "../include/SourceBuffer.h"
+#include "../include/StringInterner.h"
+#include "../include/Tokenizer.h"
+
+void fuzz::lex(const std::string_view input) {
+    const SourceBuffer source = SourceBuffer::fromMemory(input, "fuzz");
+    StringInterner     interner;
+    Diagnostics        diagnostics(source);
+    Tokenizer          tokenizer(source, interner, &diagnostics);
+    tokenizer.tokenize();
+}
+
+void fuzz::parse(const std::string_view input) {
+    const SourceBuffer source = SourceBuffer::fromMemory(input, "fuzz");
+    StringInterner     interner;
+    Diagnostics        diagnostics(source);
+    Tokenizer          tokenizer(source, interner, &diagnostics);
+    Parser             parser(&diagnostics);
+    parser.parse(tokenizer);
+}
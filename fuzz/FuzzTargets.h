@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string_view>
+
+// Compiler phases exercised by the fuzz targets and the scaling runner
+namespace fuzz {
+    // Lexes the input with a diagnostics sink, malformed input is lexed to the end instead of stopping early
+    void lex(std::string_view input);
+
+    // Lexes and parses the input with error recovery as the driver does, malformed input is parsed to the end
+    void parse(std::string_view input);
+} // namespace fuzz
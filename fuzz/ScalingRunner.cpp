@@ -0,0 +1,157 @@
+// Flags inputs whose lexing or parsing cost grows faster than linearly with the input size
+//
+// usage: scaling_runner [--max-bytes N] [--max-slope S] [inputs or corpus directories...]
+// Every input (default: ../resources/*.pc) is repeated to sizes from a few KB up to --max-bytes, the cost of each
+// size is measured and a line is fitted through log(cost) over log(size). A slope above --max-slope (default 1.3)
+// means the cost is super-linear in the input. Runs without libFuzzer, so it also works on corpora and crash inputs
+// produced elsewhere. Exits with 1 if any input was flagged.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Cost.h"
+#include "FuzzTargets.h"
+
+namespace {
+    constexpr std::size_t MIN_BYTES = 4 * 1024;
+    constexpr int         REPEATS = 3;
+
+    struct Target {
+        const char *name;
+        void (*run)(std::string_view);
+    };
+
+    constexpr std::array<Target, 2> TARGETS = {{{"lex", fuzz::lex}, {"parse", fuzz::parse}}};
+
+    auto readFile(const std::filesystem::path &path) -> std::string {
+        std::ifstream     file(path, std::ios::binary);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    // Length of a leading "program name;" header, repeated copies drop it so the result still parses
+    auto programHeaderLength(const std::string_view input) -> std::size_t {
+        const std::size_t start = input.find_first_not_of(" \t\r\n");
+        if (start == std::string_view::npos || input.substr(start, 7) != "program") {
+            return 0;
+        }
+        const std::size_t semicolon = input.find(';', start);
+        return semicolon == std::string_view::npos ? 0 : semicolon + 1;
+    }
+
+    auto repeat(const std::string_view input, const std::size_t copies) -> std::string {
+        const std::string_view body = input.substr(programHeaderLength(input));
+        std::string            result(input);
+        result.reserve(input.size() + (copies - 1) * (body.size() + 1));
+        for (std::size_t copy = 1; copy < copies; ++copy) {
+            result += '\n';
+            result += body;
+        }
+        return result;
+    }
+
+    // Least squares slope of log(y) over log(x)
+    auto logLogSlope(const std::vector<std::pair<double, double>> &points) -> double {
+        double sumX = 0;
+        double sumY = 0;
+        double sumXX = 0;
+        double sumXY = 0;
+        for (const auto &[x, y] : points) {
+            const double logX = std::log(x);
+            const double logY = std::log(std::max(y, 1.0));
+            sumX += logX;
+            sumY += logY;
+            sumXX += logX * logX;
+            sumXY += logX * logY;
+        }
+        const auto count = static_cast<double>(points.size());
+        return (count * sumXY - sumX * sumY) / (count * sumXX - sumX * sumX);
+    }
+
+    auto collectInputs(const std::vector<std::filesystem::path> &arguments) -> std::vector<std::filesystem::path> {
+        std::vector<std::filesystem::path> inputs;
+        for (const auto &argument : arguments) {
+            if (std::filesystem::is_directory(argument)) {
+                for (const auto &entry : std::filesystem::directory_iterator(argument)) {
+                    if (entry.is_regular_file()) {
+                        inputs.push_back(entry.path());
+                    }
+                }
+            } else {
+                inputs.push_back(argument);
+            }
+        }
+        std::ranges::sort(inputs);
+        return inputs;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t                        maxBytes = 512 * 1024;
+    double                             maxSlope = 1.3;
+    std::vector<std::filesystem::path> arguments;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        if (argument == "--max-bytes" && i + 1 < argc) {
+            maxBytes = std::stoul(argv[++i]);
+        } else if (argument == "--max-slope" && i + 1 < argc) {
+            maxSlope = std::stod(argv[++i]);
+        } else {
+            arguments.emplace_back(argument);
+        }
+    }
+    if (arguments.empty()) {
+        arguments.emplace_back("../resources");
+    }
+
+    CostMeter meter;
+    std::cout << "cost: " << (meter.countsInstructions() ? "retired instructions" : "thread CPU time (no perf counters)")
+              << ", sizes up to " << maxBytes << " bytes, flagging slopes above " << maxSlope << '\n';
+
+    bool flagged = false;
+    for (const auto &path : collectInputs(arguments)) {
+        const std::string input = readFile(path);
+        if (input.empty()) {
+            continue;
+        }
+
+        for (const Target &target : TARGETS) {
+            std::vector<std::pair<double, double>> work;
+            std::vector<std::pair<double, double>> heap;
+            for (std::size_t copies = std::max<std::size_t>(1, MIN_BYTES / input.size()); ; copies *= 2) {
+                const std::string scaled = repeat(input, copies);
+                Cost              best = meter.measure(target.run, scaled);
+                for (int run = 1; run < REPEATS; ++run) {
+                    const Cost cost = meter.measure(target.run, scaled);
+                    best.work = std::min(best.work, cost.work);
+                    best.peakBytes = std::min(best.peakBytes, cost.peakBytes);
+                }
+                work.emplace_back(scaled.size(), best.work);
+                heap.emplace_back(scaled.size(), best.peakBytes);
+                if (scaled.size() * 2 > maxBytes) {
+                    break;
+                }
+            }
+            if (work.size() < 3) {
+                continue;
+            }
+
+            const double workSlope = logLogSlope(work);
+            const double heapSlope = logLogSlope(heap);
+            const bool   superLinear = workSlope > maxSlope || heapSlope > maxSlope;
+            flagged = flagged || superLinear;
+
+            std::cout << (superLinear ? "SUPER-LINEAR " : "ok           ") << target.name << '\t' << "work slope "
+                      << workSlope << "\theap slope " << heapSlope << '\t' << path.string() << '\n';
+        }
+    }
+    return flagged ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+// libFuzzer target for the Tokenizer, guided by the cost per input byte on top of code coverage
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Cost.h"
+#include "FuzzTargets.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, const std::size_t size) {
+    static CostMeter meter;
+    const std::string_view input(reinterpret_cast<const char *>(data), size);
+    reportCost(meter.measure(fuzz::lex, input), size);
+    return 0;
+}
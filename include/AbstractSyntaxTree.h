@@ -1,13 +1,21 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #pragma once
 #include <iostream>
 
+#include "AstArena.h"
+#include "NumberValue.h"
+#include "StringInterner.h"
 #include "Visitor.h"
 
 namespace llvm {
@@ -37,6 +45,7 @@ class WhileLoop;
 class ReturnStatement;
 class Assignment;
 class ExpressionStatement;
+class ErrorNode;
 
 // memory management nodes
 class MemoryAllocation;
@@ -44,19 +53,69 @@ class MemoryDeallocation;
 class PointerAccess;
 class PointerAssignment;
 
-// Class representing an abstract syntax tree node
+// Operator of a BinaryOperation or UnaryOperation, set once by the parser so later phases switch on it
+enum class OperatorKind : std::uint8_t {
+    // Binary
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Modulo,
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    LogicalAnd,
+    LogicalOr,
+    BitwiseAnd,
+    BitwiseOr,
+    BitwiseXor,
+    ShiftLeft,
+    ShiftRight,
+
+    // Unary
+    Negate,
+    LogicalNot,
+};
+
+constexpr auto operatorKindToString(OperatorKind kind) -> std::string_view;
+
+// Memory of the nodes below root, root included, as the parser allocates them: nodes, child and parameter arrays
+// and the copied spellings of literals
+auto getSubtreeStatistics(const AbstractNode &root) -> AstStatistics;
+
+// Slot of a declaration, handed out by the Resolver: functions and variables (parameters included) are numbered
+// separately, from 0, one slot per declaration
+using DeclarationSlot = std::uint32_t;
+
+constexpr DeclarationSlot INVALID_SLOT = std::numeric_limits<DeclarationSlot>::max(); // not (yet) resolved
+
+// Kind of a Literal, tells which member of its NumberValue holds the value
+enum class LiteralKind : std::uint8_t { Integer, Float, Char, String };
+
+// Class representing an abstract syntax tree node.
+// Nodes are allocated in the AstArena of their Program and never destroyed individually, children are plain
+// pointers and child lists are spans into the same arena.
 class AbstractNode {
 public:
     virtual ~AbstractNode() = default;
-    AbstractNode() = default;
+    explicit AbstractNode(const NodeKind kind) : m_kind(kind) {}
     AbstractNode(const AbstractNode &node) = default;
     AbstractNode(AbstractNode &&node) noexcept = default;
     AbstractNode &operator=(const AbstractNode &node) = default;
     AbstractNode &operator=(AbstractNode &&node) noexcept = default;
 
-    virtual void print(std::string indent = "") const = 0;
+    // Prints the tree below the node, walking it with an AstWalker
+    void         print(const std::string &indent = "") const;
     virtual void accept(Visitor &visitor) = 0;
 
+    // Prints the lines of the node itself, without its children
+    virtual void printNode(const std::string &indent) const = 0;
+
+    [[nodiscard]] auto getKind() const -> NodeKind { return m_kind; }
+
     // Set and get LLVM value methods
     void setValue(llvm::Value *value) { m_llvmValue = value; }
     void setType(llvm::Type *type) { this->m_type = type; }
@@ -67,213 +126,341 @@ public:
 private:
     llvm::Value *m_llvmValue = nullptr; // Holds the LLVM value for this node
     llvm::Type  *m_type = nullptr;
+    NodeKind     m_kind;
 };
 
 // Block node, representing a sequence of statements
 class Block : public AbstractNode {
 public:
-    std::vector<std::unique_ptr<AbstractNode>> statements;
+    static constexpr NodeKind KIND = NodeKind::Block;
 
-    explicit Block(std::vector<std::unique_ptr<AbstractNode>> statements) : statements(std::move(statements)) {}
-    Block() = default;
+    std::span<AbstractNode *> statements;
 
-    void print(std::string indent) const override;
+    explicit Block(const std::span<AbstractNode *> statements) : AbstractNode(KIND), statements(statements) {}
+    Block() : AbstractNode(KIND) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
+// Token range of a top-level declaration, lets an incremental parse find the declarations an edit touches
+struct DeclarationTokens {
+    std::uint32_t begin = 0;         // index of the first token
+    std::uint32_t end = 0;           // one past the last token
+    bool          hasErrors = false; // reparsed by every incremental parse, so its diagnostics are reported again
+
+    std::array<std::uint8_t, 3> padding{}; // zeroed, the ranges are written to .pcast files byte for byte
+};
+
 // Program node, representing the entry point of the program
+// Names in the tree are spellings owned by the compilation's StringInterner, which has to outlive the Program, and
+// nothing in an error free declaration refers into the SourceBuffer, so subtrees survive edits of the source.
+// The Program is the only heap allocated node, it owns the arenas holding the rest of the tree (one per thread
+// that parsed a part of it, and one per incremental parse).
 class Program : public AbstractNode {
 public:
-    std::string            name;
-    std::unique_ptr<Block> body;
+    static constexpr NodeKind KIND = NodeKind::Program;
 
-    explicit Program(std::string name, std::unique_ptr<Block> body) : name(std::move(name)), body(std::move(body)) {}
-    Program() = default;
+    std::string_view                       name;
+    Block                                 *body = nullptr;
+    std::vector<DeclarationTokens>         declarationTokens; // one per statement of body
+    std::vector<std::unique_ptr<AstArena>> arenas;
+    std::size_t                            deadBytes = 0; // used bytes of the arenas no longer part of the tree
 
-    void print(std::string indent) const override;
+    Program(const std::string_view name, Block *body, std::vector<DeclarationTokens> declarationTokens,
+            std::vector<std::unique_ptr<AstArena>> arenas) :
+        AbstractNode(KIND), name(name), body(body), declarationTokens(std::move(declarationTokens)),
+        arenas(std::move(arenas)) {}
+
+    // Memory of the tree summed over all arenas
+    [[nodiscard]] auto getStatistics() const -> AstStatistics;
+
+    // Whether more of the arenas is dead than part of the tree, see Parser::compact
+    [[nodiscard]] auto needsCompaction() const -> bool;
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Function declaration node
 class FunctionDeclaration : public AbstractNode {
 public:
+    static constexpr NodeKind KIND = NodeKind::FunctionDeclaration;
+
     class Parameter;
 
-    std::string            name;
-    std::vector<Parameter> parameters;
-    std::unique_ptr<Block> body;
-    std::string            returnType;
+    std::string_view     name;
+    SymbolId             symbol;
+    std::span<Parameter> parameters;
+    Block               *body;
+    std::string_view     returnType;
+    DeclarationSlot      slot = INVALID_SLOT;
 
-    FunctionDeclaration(std::string name, std::vector<Parameter> parameters, std::unique_ptr<Block> body,
-                        std::string returnType) :
-        name(std::move(name)), parameters(std::move(parameters)), body(std::move(body)),
-        returnType(std::move(returnType)) {}
+    FunctionDeclaration(const std::string_view name, const SymbolId symbol, const std::span<Parameter> parameters,
+                        Block *body, const std::string_view returnType) :
+        AbstractNode(KIND), name(name), symbol(symbol), parameters(parameters), body(body), returnType(returnType) {}
 
-    void print(std::string indent) const override;
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 
     class Parameter {
     public:
-        std::string type;
-        std::string name;
+        std::string_view type;
+        std::string_view name;
+        SymbolId         symbol;
+        DeclarationSlot  slot = INVALID_SLOT;
 
-        Parameter(std::string type, std::string name) : type(std::move(type)), name(std::move(name)) {}
+        Parameter(const std::string_view type, const std::string_view name, const SymbolId symbol) :
+            type(type), name(name), symbol(symbol) {}
     };
 };
 
 // Function call node
 class FunctionCall : public AbstractNode {
 public:
-    std::string                                name;
-    std::vector<std::unique_ptr<AbstractNode>> arguments;
+    static constexpr NodeKind KIND = NodeKind::FunctionCall;
 
-    FunctionCall(std::string name, std::vector<std::unique_ptr<AbstractNode>> arguments) :
-        name(std::move(name)), arguments(std::move(arguments)) {}
+    std::string_view          name;
+    SymbolId                  symbol;
+    std::span<AbstractNode *> arguments;
+    DeclarationSlot           slot = INVALID_SLOT; // of the called function, unresolved for built-in functions
 
-    void print(std::string indent) const override;
+    FunctionCall(const std::string_view name, const SymbolId symbol, const std::span<AbstractNode *> arguments) :
+        AbstractNode(KIND), name(name), symbol(symbol), arguments(arguments) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 class VariableDeclaration : public AbstractNode {
 public:
-    std::string                   type;
-    std::string                   name;
-    bool                          isPointer;
-    bool                          isReference;
-    std::unique_ptr<AbstractNode> initializer;
-
-    VariableDeclaration(const std::string &type, const std::string &name, const bool isPointer, const bool isReference,
-                        std::unique_ptr<AbstractNode> initializer) :
-        type(type), name(name), isPointer(isPointer), isReference(isReference), initializer(std::move(initializer)) {}
-
-    VariableDeclaration(std::string type, std::string name, std::unique_ptr<AbstractNode> initializer) :
-        type(std::move(type)), name(std::move(name)), isPointer(false), isReference(false),
-        initializer(std::move(initializer)) {}
-
-    VariableDeclaration(std::string type, std::string name, std::unique_ptr<AbstractNode> initializer,
-                        const bool isPointer) :
-        type(std::move(type)), name(std::move(name)), isPointer(isPointer), isReference(false),
-        initializer(std::move(initializer)) {}
-
-    void print(std::string indent) const override;
+    static constexpr NodeKind KIND = NodeKind::VariableDeclaration;
+
+    std::string_view type;
+    std::string_view name;
+    SymbolId         symbol;
+    bool             isPointer;
+    bool             isReference;
+    AbstractNode    *initializer;
+    DeclarationSlot  slot = INVALID_SLOT;
+
+    VariableDeclaration(const std::string_view type, const std::string_view name, const SymbolId symbol,
+                        const bool isPointer, const bool isReference, AbstractNode *initializer) :
+        AbstractNode(KIND), type(type), name(name), symbol(symbol), isPointer(isPointer), isReference(isReference),
+        initializer(initializer) {}
+
+    VariableDeclaration(const std::string_view type, const std::string_view name, const SymbolId symbol,
+                        AbstractNode *initializer) :
+        AbstractNode(KIND), type(type), name(name), symbol(symbol), isPointer(false), isReference(false),
+        initializer(initializer) {}
+
+    VariableDeclaration(const std::string_view type, const std::string_view name, const SymbolId symbol,
+                        AbstractNode *initializer, const bool isPointer) :
+        AbstractNode(KIND), type(type), name(name), symbol(symbol), isPointer(isPointer), isReference(false),
+        initializer(initializer) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Literal node (e.g., numbers, strings)
 class Literal : public AbstractNode {
 public:
-    std::string value;
-    std::string type;
+    static constexpr NodeKind KIND = NodeKind::Literal;
 
-    explicit Literal(std::string value, std::string type) : value(std::move(value)), type(std::move(type)) {}
+    LiteralKind      literalKind; // first, so it fits into the tail padding of AbstractNode
+    NumberValue      number;      // converted by the lexer, Integer and Float literals only
+    std::string_view value;       // spelling as written, without the quotes of Char and String literals
 
-    void print(std::string indent) const override;
+    Literal(const LiteralKind literalKind, const std::string_view value, const NumberValue number = {}) :
+        AbstractNode(KIND), literalKind(literalKind), number(number), value(value) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Reference node (e.g., variable names, function names)
 class Reference : public AbstractNode {
 public:
-    std::string name;
-    bool        isReference;
+    static constexpr NodeKind KIND = NodeKind::Reference;
 
-    explicit Reference(std::string name, const bool isReference) : name(std::move(name)), isReference(isReference) {}
+    std::string_view name;
+    SymbolId         symbol;
+    bool             isReference;
+    DeclarationSlot  slot = INVALID_SLOT; // of the referenced variable or parameter
 
-    void print(std::string indent) const override;
+    Reference(const std::string_view name, const SymbolId symbol, const bool isReference) :
+        AbstractNode(KIND), name(name), symbol(symbol), isReference(isReference) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Binary operation node (e.g., a + b)
 class BinaryOperation : public AbstractNode {
 public:
-    std::unique_ptr<AbstractNode> left;
-    std::string                   operatorSymbol;
-    std::unique_ptr<AbstractNode> right;
+    static constexpr NodeKind KIND = NodeKind::BinaryOperation;
 
-    BinaryOperation(std::unique_ptr<AbstractNode> left, std::string operatorSymbol,
-                    std::unique_ptr<AbstractNode> right) :
-        left(std::move(left)), operatorSymbol(std::move(operatorSymbol)), right(std::move(right)) {}
+    OperatorKind  operatorKind; // first, so it fits into the tail padding of AbstractNode
+    AbstractNode *left;
+    AbstractNode *right;
 
-    void print(std::string indent) const override;
+    BinaryOperation(AbstractNode *left, const OperatorKind operatorKind, AbstractNode *right) :
+        AbstractNode(KIND), operatorKind(operatorKind), left(left), right(right) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Unary operation node (e.g., -a)
 class UnaryOperation : public AbstractNode {
 public:
-    std::unique_ptr<AbstractNode> operand;
-    std::string                   operatorSymbol;
+    static constexpr NodeKind KIND = NodeKind::UnaryOperation;
 
-    UnaryOperation(std::unique_ptr<AbstractNode> operand, std::string operatorSymbol) :
-        operand(std::move(operand)), operatorSymbol(std::move(operatorSymbol)) {}
+    OperatorKind  operatorKind; // first, so it fits into the tail padding of AbstractNode
+    AbstractNode *operand;
 
-    void print(std::string indent) const override;
+    UnaryOperation(AbstractNode *operand, const OperatorKind operatorKind) :
+        AbstractNode(KIND), operatorKind(operatorKind), operand(operand) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // If statement node
 class IfStatement : public AbstractNode {
 public:
-    std::unique_ptr<AbstractNode> condition;
-    std::unique_ptr<Block>        thenBranch;
-    std::unique_ptr<Block>        elseBranch;
+    static constexpr NodeKind KIND = NodeKind::IfStatement;
 
-    IfStatement(std::unique_ptr<AbstractNode> condition, std::unique_ptr<Block> thenBranch,
-                std::unique_ptr<Block> elseBranch = nullptr) :
-        condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)) {}
+    AbstractNode *condition;
+    Block        *thenBranch;
+    Block        *elseBranch;
 
-    void print(std::string indent) const override;
+    IfStatement(AbstractNode *condition, Block *thenBranch, Block *elseBranch = nullptr) :
+        AbstractNode(KIND), condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // While loop node
 class WhileLoop : public AbstractNode {
 public:
-    std::unique_ptr<AbstractNode> condition;
-    std::unique_ptr<Block>        body;
+    static constexpr NodeKind KIND = NodeKind::WhileLoop;
 
-    WhileLoop(std::unique_ptr<AbstractNode> condition, std::unique_ptr<Block> body) :
-        condition(std::move(condition)), body(std::move(body)) {}
+    AbstractNode *condition;
+    Block        *body;
 
-    void print(std::string indent) const override;
+    WhileLoop(AbstractNode *condition, Block *body) : AbstractNode(KIND), condition(condition), body(body) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Return statement node
 class ReturnStatement : public AbstractNode {
 public:
-    std::unique_ptr<AbstractNode> expression;
+    static constexpr NodeKind KIND = NodeKind::ReturnStatement;
 
-    explicit ReturnStatement(std::unique_ptr<AbstractNode> expression) : expression(std::move(expression)) {}
+    AbstractNode *expression;
 
-    void print(std::string indent) const override;
+    explicit ReturnStatement(AbstractNode *expression) : AbstractNode(KIND), expression(expression) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Expression statement node (e.g., standalone expressions in a block)
 class ExpressionStatement : public AbstractNode {
 public:
-    std::unique_ptr<AbstractNode> expression;
+    static constexpr NodeKind KIND = NodeKind::ExpressionStatement;
 
-    explicit ExpressionStatement(std::unique_ptr<AbstractNode> expression) : expression(std::move(expression)) {}
+    AbstractNode *expression;
 
-    void print(std::string indent) const override;
+    explicit ExpressionStatement(AbstractNode *expression) : AbstractNode(KIND), expression(expression) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
 
 // Assignment node
 class Assignment : public AbstractNode {
 public:
-    std::string                   name;
-    std::unique_ptr<AbstractNode> value;
-    bool                          isPointerDereference;
+    static constexpr NodeKind KIND = NodeKind::Assignment;
 
-    Assignment(std::string name, std::unique_ptr<AbstractNode> value, const bool isPointerDereference) :
-        name(std::move(name)), value(std::move(value)), isPointerDereference(isPointerDereference) {}
+    std::string_view name;
+    SymbolId         symbol;
+    AbstractNode    *value;
+    bool             isPointerDereference;
+    DeclarationSlot  slot = INVALID_SLOT; // of the assigned variable or parameter
 
-    void print(std::string indent) const override;
+    Assignment(const std::string_view name, const SymbolId symbol, AbstractNode *value,
+               const bool isPointerDereference) :
+        AbstractNode(KIND), name(name), symbol(symbol), value(value), isPointerDereference(isPointerDereference) {}
+
+    void printNode(const std::string &indent) const override;
     void accept(Visitor &visitor) override { visitor.visit(*this); }
 };
+
+// Error node, stands in for a declaration or statement that failed to parse when the parser recovers from errors
+class ErrorNode : public AbstractNode {
+public:
+    static constexpr NodeKind KIND = NodeKind::Error;
+
+    std::uint32_t    offset;  // source offset of the token the error was found at
+    std::string_view message; // static text, the same as in the diagnostic
+
+    ErrorNode(const std::uint32_t offset, const std::string_view message) :
+        AbstractNode(KIND), offset(offset), message(message) {}
+
+    void printNode(const std::string &indent) const override;
+    void accept(Visitor &visitor) override { visitor.visit(*this); }
+};
+
+constexpr auto operatorKindToString(const OperatorKind kind) -> std::string_view {
+    switch (kind) {
+        case OperatorKind::Add:
+            return "+";
+        case OperatorKind::Subtract:
+        case OperatorKind::Negate:
+            return "-";
+        case OperatorKind::Multiply:
+            return "*";
+        case OperatorKind::Divide:
+            return "/";
+        case OperatorKind::Modulo:
+            return "%";
+        case OperatorKind::Equal:
+            return "==";
+        case OperatorKind::NotEqual:
+            return "!=";
+        case OperatorKind::Less:
+            return "<";
+        case OperatorKind::LessEqual:
+            return "<=";
+        case OperatorKind::Greater:
+            return ">";
+        case OperatorKind::GreaterEqual:
+            return ">=";
+        case OperatorKind::LogicalAnd:
+            return "&&";
+        case OperatorKind::LogicalOr:
+            return "||";
+        case OperatorKind::BitwiseAnd:
+            return "&";
+        case OperatorKind::BitwiseOr:
+            return "|";
+        case OperatorKind::BitwiseXor:
+            return "^";
+        case OperatorKind::ShiftLeft:
+            return "<<";
+        case OperatorKind::ShiftRight:
+            return ">>";
+        case OperatorKind::LogicalNot:
+            return "!";
+    }
+    return "?";
+}
 /*
 // Memory allocation node
 class MemoryAllocation : public AbstractNode {
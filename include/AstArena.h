@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <llvm/Support/Allocator.h>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Concrete kind of an AST node, every node class names its kind in a static KIND member
+enum class NodeKind : std::uint8_t {
+    Program,
+    Block,
+    FunctionDeclaration,
+    FunctionCall,
+    VariableDeclaration,
+    Literal,
+    Reference,
+    BinaryOperation,
+    UnaryOperation,
+    IfStatement,
+    WhileLoop,
+    ReturnStatement,
+    ExpressionStatement,
+    Assignment,
+    Error,
+};
+
+constexpr std::size_t NODE_KIND_COUNT = static_cast<std::size_t>(NodeKind::Error) + 1;
+
+constexpr auto nodeKindToString(NodeKind kind) -> std::string_view;
+
+// Memory used by the AST of one compilation
+struct AstStatistics {
+    std::array<std::size_t, NODE_KIND_COUNT> nodeCounts{};
+    std::size_t                              nodeBytes = 0;     // node objects
+    std::size_t                              listBytes = 0;     // child and parameter arrays
+    std::size_t                              stringBytes = 0;   // strings that are not views into the source
+    std::size_t                              reservedBytes = 0; // slabs taken from the heap, including unused tails
+
+    [[nodiscard]] auto getNodeCount() const -> std::size_t;
+    [[nodiscard]] auto getUsedBytes() const -> std::size_t;
+
+    auto operator+=(const AstStatistics &other) -> AstStatistics &;
+
+    void print(std::ostream &out) const;
+};
+
+// Per-compilation bump allocator for AST nodes, their child arrays and strings.
+// Nodes are placed one after another in large slabs and are never destroyed one by one: everything they own lives
+// in the same arena, so dropping the arena releases the whole tree with a handful of slab frees instead of a
+// destructor call per node.
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    // Constructs a node in the arena, the node must only own memory of this arena
+    template <typename Node, typename... Args>
+    auto create(Args &&...args) -> Node *;
+
+    // Takes a node that did not become part of the tree out of the statistics, its memory stays reserved
+    template <typename Node>
+    void discard(const Node &node);
+
+    // Copies the elements into an array of the arena
+    template <typename T>
+    auto copyArray(std::span<const T> elements) -> std::span<T>;
+
+    // Copies a string that does not live in the source buffer into the arena
+    auto copyString(std::string_view text) -> std::string_view;
+
+    [[nodiscard]] auto getStatistics() const -> AstStatistics;
+
+private:
+    llvm::BumpPtrAllocator m_allocator;
+    AstStatistics          m_statistics;
+};
+
+template <typename Node, typename... Args>
+auto AstArena::create(Args &&...args) -> Node * {
+    m_statistics.nodeCounts[static_cast<std::size_t>(Node::KIND)]++;
+    m_statistics.nodeBytes += sizeof(Node);
+    return new (m_allocator.Allocate<Node>()) Node(std::forward<Args>(args)...);
+}
+
+template <typename Node>
+void AstArena::discard(const Node &node) {
+    m_statistics.nodeCounts[static_cast<std::size_t>(node.getKind())]--;
+    m_statistics.nodeBytes -= sizeof(Node);
+}
+
+template <typename T>
+auto AstArena::copyArray(const std::span<const T> elements) -> std::span<T> {
+    static_assert(std::is_trivially_destructible_v<T>, "AstArena: arrays are never destroyed");
+    if (elements.empty()) {
+        return {};
+    }
+    m_statistics.listBytes += elements.size_bytes();
+    T *copy = m_allocator.Allocate<T>(elements.size());
+    std::uninitialized_copy(elements.begin(), elements.end(), copy);
+    return {copy, elements.size()};
+}
+
+inline auto AstArena::copyString(const std::string_view text) -> std::string_view {
+    if (text.empty()) {
+        return {};
+    }
+    m_statistics.stringBytes += text.size();
+    char *copy = m_allocator.Allocate<char>(text.size());
+    std::memcpy(copy, text.data(), text.size());
+    return {copy, text.size()};
+}
+
+inline auto AstArena::getStatistics() const -> AstStatistics {
+    AstStatistics statistics = m_statistics;
+    statistics.reservedBytes = m_allocator.getTotalMemory();
+    return statistics;
+}
+
+inline auto AstStatistics::getNodeCount() const -> std::size_t {
+    std::size_t count = 0;
+    for (const std::size_t kindCount : nodeCounts) {
+        count += kindCount;
+    }
+    return count;
+}
+
+inline auto AstStatistics::getUsedBytes() const -> std::size_t { return nodeBytes + listBytes + stringBytes; }
+
+inline auto AstStatistics::operator+=(const AstStatistics &other) -> AstStatistics & {
+    for (std::size_t kind = 0; kind < NODE_KIND_COUNT; ++kind) {
+        nodeCounts[kind] += other.nodeCounts[kind];
+    }
+    nodeBytes += other.nodeBytes;
+    listBytes += other.listBytes;
+    stringBytes += other.stringBytes;
+    reservedBytes += other.reservedBytes;
+    return *this;
+}
+
+constexpr auto nodeKindToString(const NodeKind kind) -> std::string_view {
+    switch (kind) {
+        case NodeKind::Program:
+            return "Program";
+        case NodeKind::Block:
+            return "Block";
+        case NodeKind::FunctionDeclaration:
+            return "FunctionDeclaration";
+        case NodeKind::FunctionCall:
+            return "FunctionCall";
+        case NodeKind::VariableDeclaration:
+            return "VariableDeclaration";
+        case NodeKind::Literal:
+            return "Literal";
+        case NodeKind::Reference:
+            return "Reference";
+        case NodeKind::BinaryOperation:
+            return "BinaryOperation";
+        case NodeKind::UnaryOperation:
+            return "UnaryOperation";
+        case NodeKind::IfStatement:
+            return "IfStatement";
+        case NodeKind::WhileLoop:
+            return "WhileLoop";
+        case NodeKind::ReturnStatement:
+            return "ReturnStatement";
+        case NodeKind::ExpressionStatement:
+            return "ExpressionStatement";
+        case NodeKind::Assignment:
+            return "Assignment";
+        case NodeKind::Error:
+            return "Error";
+    }
+    return "Unknown";
+}
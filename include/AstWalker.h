@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "AbstractSyntaxTree.h"
+
+// Calls visit(child) for the children of a node in source order, absent optional children are skipped
+template <typename Visit>
+void forEachChild(const AbstractNode &node, Visit &&visit);
+
+// forEachChild for a node of a known class, without the switch over the kind
+template <typename Node, typename Visit>
+void forEachChildOf(const Node &node, Visit &&visit);
+
+// static_cast of a node to its concrete class, keeping the constness
+template <typename Concrete, typename Node>
+auto castNode(Node &node) -> std::conditional_t<std::is_const_v<Node>, const Concrete, Concrete> &;
+
+// Returns function(node) with the node cast to its concrete class, a switch over the kind tag
+template <typename Node, typename Function>
+decltype(auto) dispatchNode(Node &node, Function &&function);
+
+// Depth-first walk of a tree on an explicit stack instead of the native one, so the depth of the tree is only
+// limited by heap memory and every level costs one stack entry. The stack is kept between walks.
+class AstWalker {
+public:
+    // enter(node, parent, depth) is called before the children of a node and returns whether to walk them,
+    // leave(node, parent) after them, also if they were skipped. The parent of the root is nullptr. Walks may nest.
+    template <typename Enter, typename Leave>
+    void walk(AbstractNode &root, Enter &&enter, Leave &&leave);
+
+private:
+    struct Frame {
+        AbstractNode *node;
+        AbstractNode *parent;
+        std::size_t   depth;
+        bool          leaving; // the children have been walked
+    };
+
+    std::vector<Frame> m_stack;
+};
+
+template <typename Node, typename Visit>
+void forEachChildOf(const Node &node, Visit &&visit) {
+    const auto visitIfPresent = [&](AbstractNode *child) {
+        if (child != nullptr) {
+            visit(child);
+        }
+    };
+
+    if constexpr (std::is_same_v<Node, Program>) {
+        visitIfPresent(node.body);
+    } else if constexpr (std::is_same_v<Node, Block>) {
+        std::ranges::for_each(node.statements, visitIfPresent);
+    } else if constexpr (std::is_same_v<Node, FunctionDeclaration>) {
+        visitIfPresent(node.body);
+    } else if constexpr (std::is_same_v<Node, FunctionCall>) {
+        std::ranges::for_each(node.arguments, visitIfPresent);
+    } else if constexpr (std::is_same_v<Node, VariableDeclaration>) {
+        visitIfPresent(node.initializer);
+    } else if constexpr (std::is_same_v<Node, BinaryOperation>) {
+        visitIfPresent(node.left);
+        visitIfPresent(node.right);
+    } else if constexpr (std::is_same_v<Node, UnaryOperation>) {
+        visitIfPresent(node.operand);
+    } else if constexpr (std::is_same_v<Node, IfStatement>) {
+        visitIfPresent(node.condition);
+        visitIfPresent(node.thenBranch);
+        visitIfPresent(node.elseBranch);
+    } else if constexpr (std::is_same_v<Node, WhileLoop>) {
+        visitIfPresent(node.condition);
+        visitIfPresent(node.body);
+    } else if constexpr (std::is_same_v<Node, ReturnStatement> || std::is_same_v<Node, ExpressionStatement>) {
+        visitIfPresent(node.expression);
+    } else if constexpr (std::is_same_v<Node, Assignment>) {
+        visitIfPresent(node.value);
+    } else {
+        static_assert(std::is_same_v<Node, Literal> || std::is_same_v<Node, Reference> ||
+                              std::is_same_v<Node, ErrorNode>,
+                      "forEachChildOf: unknown node class");
+    }
+}
+
+template <typename Visit>
+void forEachChild(const AbstractNode &node, Visit &&visit) {
+    dispatchNode(node, [&](const auto &typed) { forEachChildOf(typed, visit); });
+}
+
+template <typename Concrete, typename Node>
+auto castNode(Node &node) -> std::conditional_t<std::is_const_v<Node>, const Concrete, Concrete> & {
+    return static_cast<std::conditional_t<std::is_const_v<Node>, const Concrete, Concrete> &>(node);
+}
+
+template <typename Node, typename Function>
+decltype(auto) dispatchNode(Node &node, Function &&function) {
+    switch (node.getKind()) {
+        case NodeKind::Program:
+            return function(castNode<Program>(node));
+        case NodeKind::Block:
+            return function(castNode<Block>(node));
+        case NodeKind::FunctionDeclaration:
+            return function(castNode<FunctionDeclaration>(node));
+        case NodeKind::FunctionCall:
+            return function(castNode<FunctionCall>(node));
+        case NodeKind::VariableDeclaration:
+            return function(castNode<VariableDeclaration>(node));
+        case NodeKind::Literal:
+            return function(castNode<Literal>(node));
+        case NodeKind::Reference:
+            return function(castNode<Reference>(node));
+        case NodeKind::BinaryOperation:
+            return function(castNode<BinaryOperation>(node));
+        case NodeKind::UnaryOperation:
+            return function(castNode<UnaryOperation>(node));
+        case NodeKind::IfStatement:
+            return function(castNode<IfStatement>(node));
+        case NodeKind::WhileLoop:
+            return function(castNode<WhileLoop>(node));
+        case NodeKind::ReturnStatement:
+            return function(castNode<ReturnStatement>(node));
+        case NodeKind::ExpressionStatement:
+            return function(castNode<ExpressionStatement>(node));
+        case NodeKind::Assignment:
+            return function(castNode<Assignment>(node));
+        case NodeKind::Error:
+            break;
+    }
+    return function(castNode<ErrorNode>(node));
+}
+
+template <typename Enter, typename Leave>
+void AstWalker::walk(AbstractNode &root, Enter &&enter, Leave &&leave) {
+    const std::size_t base = m_stack.size();
+    m_stack.push_back({&root, nullptr, 0, false});
+    while (m_stack.size() > base) {
+        Frame &frame = m_stack.back();
+        if (frame.leaving) {
+            const Frame finished = frame;
+            m_stack.pop_back();
+            leave(*finished.node, finished.parent);
+            continue;
+        }
+
+        frame.leaving = true;
+        AbstractNode     *node = frame.node;
+        const std::size_t depth = frame.depth;
+        if (!enter(*node, frame.parent, depth)) {
+            continue;
+        }
+        // children are pushed in source order and reversed, so the first one is on top
+        const std::size_t first = m_stack.size();
+        forEachChild(*node, [&](AbstractNode *child) { m_stack.push_back({child, node, depth + 1, false}); });
+        std::reverse(m_stack.begin() + static_cast<std::ptrdiff_t>(first), m_stack.end());
+    }
+}
@@ -7,8 +7,12 @@
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 #include <memory>
+#include <string_view>
+#include <vector>
 
 #include "AbstractSyntaxTree.h"
+#include "AstWalker.h"
+#include "Resolver.h"
 #include "Visitor.h"
 
 class CodeGenerator : public Visitor {
@@ -16,18 +20,36 @@ public:
     llvm::LLVMContext             context;
     std::unique_ptr<llvm::Module> module;
     llvm::IRBuilder<>             builder;
-    std::unordered_map<std::string, llvm::Value *>
-            refNameToValue; // Map of reference name to LLVM value (pointer or literal value)
-    std::unordered_map<std::string, llvm::Type *> refNameToType;
+
+    // LLVM value (pointer or literal value) and type of each variable and the LLVM function of each function,
+    // indexed by the DeclarationSlot the Resolver gave the declaration
+    std::vector<llvm::Value *>    variableValues;
+    std::vector<llvm::Type *>     variableTypes;
+    std::vector<llvm::Function *> functions;
 
     CodeGenerator();
-    void generateCode(const std::unique_ptr<Program> &program);
 
-    auto typeToLLVMType(const std::string &type) -> llvm::Type *;
-    auto getValueFromLiteral(const std::string &value, const std::string &type) -> llvm::Value *;
-    auto getBinaryLLVM(const std::string &op, llvm::Value *leftValue, llvm::Value *rightValue) -> llvm::Value *;
-    auto getUnaryLLVM(const std::string &op, llvm::Value *value) -> llvm::Value *;
-    auto implicitConvert(llvm::Value *value, llvm::Type *targetType, const std::string &name) -> llvm::Value *;
+    // Generates the code of a program resolved by the Resolver
+    void generateCode(const std::unique_ptr<Program> &program, const Resolution &resolution);
+
+    // Generates the code of a node. Neither statements nor expressions recurse: a statement containing blocks
+    // schedules them as tasks, which are run here, and expressions are walked by generateExpression.
+    void generate(AbstractNode &node);
+
+    // Generates the operands of an expression before the operation using them, which takes them from m_operands
+    void generateExpression(AbstractNode &expression);
+
+    void bindVariable(DeclarationSlot slot, llvm::Value *value, llvm::Type *type);
+    void bindFunction(DeclarationSlot slot, llvm::Function *function);
+    [[nodiscard]] auto lookupValue(DeclarationSlot slot) const -> llvm::Value *;
+    [[nodiscard]] auto lookupType(DeclarationSlot slot) const -> llvm::Type *;
+    [[nodiscard]] auto lookupFunction(DeclarationSlot slot) const -> llvm::Function *;
+
+    auto typeToLLVMType(std::string_view type) -> llvm::Type *;
+    auto getValueFromLiteral(const Literal &literal) -> llvm::Value *;
+    auto getBinaryLLVM(OperatorKind op, llvm::Value *leftValue, llvm::Value *rightValue) -> llvm::Value *;
+    auto getUnaryLLVM(OperatorKind op, llvm::Value *value) -> llvm::Value *;
+    auto implicitConvert(llvm::Value *value, llvm::Type *targetType, const llvm::Twine &name) -> llvm::Value *;
 
     // Visitor functions
     void visit(Block &node) override;
@@ -44,4 +66,58 @@ public:
     void visit(ReturnStatement &node) override;
     void visit(ExpressionStatement &node) override;
     void visit(Assignment &node) override;
+    void visit(ErrorNode &node) override;
+
+private:
+    // Work of a statement that has to wait for the code of a nested block, run last in first out
+    struct Task {
+        enum class Kind : std::uint8_t {
+            Generate, // generate the statement or block
+            Branch,   // branch to the basic block
+            InsertAt, // continue in the basic block
+        };
+
+        Kind              kind;
+        AbstractNode     *node = nullptr;
+        llvm::BasicBlock *block = nullptr;
+    };
+
+    std::vector<Task>          m_tasks;
+    std::vector<llvm::Value *> m_operands; // loaded values of the operands of operations being generated
+    AstWalker                  m_walker;
+
+    void generateStatement(AbstractNode &statement);
+
+    // Value of a finished operand as the operation uses it, variables are loaded
+    auto loadOperand(AbstractNode &operand, const AbstractNode &operation) -> llvm::Value *;
+
+    // Takes the values of the last count operands off m_operands
+    auto popOperands(std::size_t count) -> std::vector<llvm::Value *>;
 };
+
+// Returns the entry for slot, or nullptr if the name was left unresolved or nothing has been bound to it yet
+template <typename T>
+auto lookupSlot(const std::vector<T *> &table, const DeclarationSlot slot) -> T * {
+    return slot == INVALID_SLOT ? nullptr : table[slot];
+}
+
+inline void CodeGenerator::bindVariable(const DeclarationSlot slot, llvm::Value *value, llvm::Type *type) {
+    variableValues[slot] = value;
+    variableTypes[slot] = type;
+}
+
+inline void CodeGenerator::bindFunction(const DeclarationSlot slot, llvm::Function *function) {
+    functions[slot] = function;
+}
+
+inline auto CodeGenerator::lookupValue(const DeclarationSlot slot) const -> llvm::Value * {
+    return lookupSlot(variableValues, slot);
+}
+
+inline auto CodeGenerator::lookupType(const DeclarationSlot slot) const -> llvm::Type * {
+    return lookupSlot(variableTypes, slot);
+}
+
+inline auto CodeGenerator::lookupFunction(const DeclarationSlot slot) const -> llvm::Function * {
+    return lookupSlot(functions, slot);
+}
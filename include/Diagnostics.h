@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SourceBuffer.h"
+
+// Range of source bytes a diagnostic points at
+struct SourceSpan {
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+};
+
+// A single error, the message is static text so recording one allocates nothing beyond the vector slot
+struct Diagnostic {
+    SourceSpan       span;
+    std::string_view message;
+};
+
+// Collects the errors of one source so a phase can report all of them instead of stopping at the first.
+// Positions are only computed when the diagnostics are formatted.
+class Diagnostics {
+public:
+    explicit Diagnostics(const SourceBuffer &source);
+
+    void error(SourceSpan span, std::string_view message);
+
+    [[nodiscard]] auto hasErrors() const -> bool;
+    [[nodiscard]] auto getDiagnostics() const -> const std::vector<Diagnostic> &;
+
+    // Prints every diagnostic followed by its source line with the span underlined
+    void print(std::ostream &out) const;
+
+    // Formats a diagnostic as name:line:column: error: message
+    static auto format(const SourceBuffer &source, const Diagnostic &diagnostic) -> std::string;
+
+private:
+    const SourceBuffer     *m_source;
+    std::vector<Diagnostic> m_diagnostics;
+};
+
+inline auto Diagnostics::hasErrors() const -> bool { return !m_diagnostics.empty(); }
+
+inline auto Diagnostics::getDiagnostics() const -> const std::vector<Diagnostic> & { return m_diagnostics; }
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "AbstractSyntaxTree.h"
+
+// Id of a node in a FlatAst, nodes are numbered in pre-order starting with the Program at 0
+using FlatNodeId = std::uint32_t;
+
+constexpr FlatNodeId INVALID_FLAT_NODE = std::numeric_limits<FlatNodeId>::max(); // an absent optional child
+
+// Text in the string pool of a FlatAst
+struct FlatText {
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+};
+
+// Run of entries in the child or parameter pool of a FlatAst
+struct FlatRange {
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;
+};
+
+// Records of the flat nodes, one per node kind with the fields of its node class. Children are node ids.
+// Padding is spelled out as zeroed members, records are written to .pcast files byte for byte.
+
+struct FlatProgram {
+    static constexpr NodeKind KIND = NodeKind::Program;
+
+    FlatText   name;
+    FlatNodeId body = INVALID_FLAT_NODE;
+};
+
+struct FlatBlock {
+    static constexpr NodeKind KIND = NodeKind::Block;
+
+    FlatRange statements; // in the child pool
+};
+
+struct FlatParameter {
+    FlatText type;
+    FlatText name;
+    SymbolId symbol = INVALID_SYMBOL;
+};
+
+struct FlatFunctionDeclaration {
+    static constexpr NodeKind KIND = NodeKind::FunctionDeclaration;
+
+    FlatText   name;
+    SymbolId   symbol = INVALID_SYMBOL;
+    FlatRange  parameters; // in the parameter pool
+    FlatNodeId body = INVALID_FLAT_NODE;
+    FlatText   returnType;
+};
+
+struct FlatFunctionCall {
+    static constexpr NodeKind KIND = NodeKind::FunctionCall;
+
+    FlatText  name;
+    SymbolId  symbol = INVALID_SYMBOL;
+    FlatRange arguments; // in the child pool
+};
+
+struct FlatVariableDeclaration {
+    static constexpr NodeKind KIND = NodeKind::VariableDeclaration;
+
+    FlatText   type;
+    FlatText   name;
+    SymbolId   symbol = INVALID_SYMBOL;
+    FlatNodeId initializer = INVALID_FLAT_NODE;
+    bool       isPointer = false;
+    bool       isReference = false;
+
+    std::array<std::uint8_t, 2> padding{};
+};
+
+struct FlatLiteral {
+    static constexpr NodeKind KIND = NodeKind::Literal;
+
+    NumberValue number{};
+    FlatText    value;
+    LiteralKind literalKind = LiteralKind::Integer;
+
+    std::array<std::uint8_t, 7> padding{};
+};
+
+struct FlatReference {
+    static constexpr NodeKind KIND = NodeKind::Reference;
+
+    FlatText name;
+    SymbolId symbol = INVALID_SYMBOL;
+    bool     isReference = false;
+
+    std::array<std::uint8_t, 3> padding{};
+};
+
+struct FlatBinaryOperation {
+    static constexpr NodeKind KIND = NodeKind::BinaryOperation;
+
+    FlatNodeId   left = INVALID_FLAT_NODE;
+    FlatNodeId   right = INVALID_FLAT_NODE;
+    OperatorKind operatorKind{};
+
+    std::array<std::uint8_t, 3> padding{};
+};
+
+struct FlatUnaryOperation {
+    static constexpr NodeKind KIND = NodeKind::UnaryOperation;
+
+    FlatNodeId   operand = INVALID_FLAT_NODE;
+    OperatorKind operatorKind{};
+
+    std::array<std::uint8_t, 3> padding{};
+};
+
+struct FlatIfStatement {
+    static constexpr NodeKind KIND = NodeKind::IfStatement;
+
+    FlatNodeId condition = INVALID_FLAT_NODE;
+    FlatNodeId thenBranch = INVALID_FLAT_NODE;
+    FlatNodeId elseBranch = INVALID_FLAT_NODE;
+};
+
+struct FlatWhileLoop {
+    static constexpr NodeKind KIND = NodeKind::WhileLoop;
+
+    FlatNodeId condition = INVALID_FLAT_NODE;
+    FlatNodeId body = INVALID_FLAT_NODE;
+};
+
+struct FlatReturnStatement {
+    static constexpr NodeKind KIND = NodeKind::ReturnStatement;
+
+    FlatNodeId expression = INVALID_FLAT_NODE;
+};
+
+struct FlatExpressionStatement {
+    static constexpr NodeKind KIND = NodeKind::ExpressionStatement;
+
+    FlatNodeId expression = INVALID_FLAT_NODE;
+};
+
+struct FlatAssignment {
+    static constexpr NodeKind KIND = NodeKind::Assignment;
+
+    FlatText   name;
+    SymbolId   symbol = INVALID_SYMBOL;
+    FlatNodeId value = INVALID_FLAT_NODE;
+    bool       isPointerDereference = false;
+
+    std::array<std::uint8_t, 3> padding{};
+};
+
+struct FlatError {
+    static constexpr NodeKind KIND = NodeKind::Error;
+
+    std::uint32_t offset = 0;
+    FlatText      message;
+};
+
+// Flat, index based form of a Program. A node is a kind byte and a 32-bit slot into the contiguous array of its
+// kind, children are 32-bit node ids, and there is no vtable or LLVM state per node. Nodes are numbered in
+// pre-order, so walking the whole tree is a linear scan over the ids (a parent always comes before its children)
+// and a pass over every node of one kind is a linear scan over the records of that kind.
+// The pointer tree converts into a FlatAst and back, so passes can move over while the Visitor based ones keep
+// working. Strings are copied into the FlatAst, it depends on neither the Program nor the interner once built.
+// Since nothing in it is a pointer, a FlatAst is also the on-disk form of a parsed file (.pcast, see save).
+class FlatAst {
+public:
+    static auto fromProgram(const Program &program) -> FlatAst;
+
+    // Reads a .pcast file written by save. The file is memory-mapped and every array of the tree is one block copy
+    // out of it, there is nothing to fix up but the symbols, which are interned into interner. Throws a
+    // std::runtime_error if the file can't be read, was written by another version or layout, or is corrupt.
+    static auto load(const std::string &path, StringInterner &interner) -> FlatAst;
+
+    // Writes the tree as a .pcast file: a versioned header, a table of sections and one section per array of the
+    // tree, plus a table with the spelling of every symbol. Throws a std::runtime_error if the file can't be written.
+    void save(const std::string &path) const;
+
+    // Builds a pointer tree of the same shape and contents in a fresh arena
+    [[nodiscard]] auto toProgram() const -> std::unique_ptr<Program>;
+
+    [[nodiscard]] auto size() const -> std::size_t;
+    [[nodiscard]] auto getKind(FlatNodeId id) const -> NodeKind;
+
+    // Record of a node of the record's kind
+    template <typename Record>
+    [[nodiscard]] auto get(FlatNodeId id) const -> const Record &;
+
+    // Records of every node of one kind, in pre-order
+    template <typename Record>
+    [[nodiscard]] auto records() const -> std::span<const Record>;
+
+    [[nodiscard]] auto getChildren(FlatRange range) const -> std::span<const FlatNodeId>;
+    [[nodiscard]] auto getParameters(FlatRange range) const -> std::span<const FlatParameter>;
+    [[nodiscard]] auto getText(FlatText text) const -> std::string_view;
+    [[nodiscard]] auto getDeclarationTokens() const -> std::span<const DeclarationTokens>;
+
+    // Calls visit(child) for the children of a node in source order, absent optional children are skipped
+    template <typename Visit>
+    void forEachChild(FlatNodeId id, Visit &&visit) const;
+
+    // Memory of the flat tree in the terms of the pointer tree: node bytes are the kind tags, slots and records,
+    // list bytes the child and parameter pools
+    [[nodiscard]] auto getStatistics() const -> AstStatistics;
+
+private:
+    class Builder;
+
+    // Calls function(array) for every array of the tree, in the order of the sections of a .pcast file
+    template <typename Self, typename Function>
+    static void forEachArray(Self &flat, Function &&function);
+
+    // Calls function(symbol, name) for every symbol in the tree along with the name it was interned from
+    template <typename Self, typename Function>
+    static void forEachSymbol(Self &flat, Function &&function);
+
+    // Throws a std::runtime_error naming the first inconsistency that would make the tree unsafe to use,
+    // symbols holds the spelling of every symbol id
+    void validate(std::span<const FlatText> symbols) const;
+
+    std::vector<NodeKind>      m_kinds; // per node id
+    std::vector<std::uint32_t> m_slots; // per node id, index into the records of its kind
+
+    std::tuple<std::vector<FlatProgram>, std::vector<FlatBlock>, std::vector<FlatFunctionDeclaration>,
+               std::vector<FlatFunctionCall>, std::vector<FlatVariableDeclaration>, std::vector<FlatLiteral>,
+               std::vector<FlatReference>, std::vector<FlatBinaryOperation>, std::vector<FlatUnaryOperation>,
+               std::vector<FlatIfStatement>, std::vector<FlatWhileLoop>, std::vector<FlatReturnStatement>,
+               std::vector<FlatExpressionStatement>, std::vector<FlatAssignment>, std::vector<FlatError>>
+            m_records;
+
+    std::vector<FlatNodeId>        m_children;
+    std::vector<FlatParameter>     m_parameters;
+    std::string                    m_text; // every distinct string of the tree once
+    std::vector<DeclarationTokens> m_declarationTokens;
+};
+
+inline auto FlatAst::size() const -> std::size_t { return m_kinds.size(); }
+
+inline auto FlatAst::getKind(const FlatNodeId id) const -> NodeKind { return m_kinds[id]; }
+
+template <typename Record>
+auto FlatAst::get(const FlatNodeId id) const -> const Record & {
+    return std::get<std::vector<Record>>(m_records)[m_slots[id]];
+}
+
+template <typename Record>
+auto FlatAst::records() const -> std::span<const Record> {
+    return std::get<std::vector<Record>>(m_records);
+}
+
+inline auto FlatAst::getChildren(const FlatRange range) const -> std::span<const FlatNodeId> {
+    return std::span<const FlatNodeId>(m_children).subspan(range.first, range.count);
+}
+
+inline auto FlatAst::getParameters(const FlatRange range) const -> std::span<const FlatParameter> {
+    return std::span<const FlatParameter>(m_parameters).subspan(range.first, range.count);
+}
+
+inline auto FlatAst::getText(const FlatText text) const -> std::string_view {
+    return std::string_view(m_text).substr(text.offset, text.length);
+}
+
+inline auto FlatAst::getDeclarationTokens() const -> std::span<const DeclarationTokens> { return m_declarationTokens; }
+
+template <typename Visit>
+void FlatAst::forEachChild(const FlatNodeId id, Visit &&visit) const {
+    const auto visitIfPresent = [&](const FlatNodeId child) {
+        if (child != INVALID_FLAT_NODE) {
+            visit(child);
+        }
+    };
+
+    switch (getKind(id)) {
+        case NodeKind::Program:
+            visitIfPresent(get<FlatProgram>(id).body);
+            break;
+        case NodeKind::Block:
+            for (const FlatNodeId child : getChildren(get<FlatBlock>(id).statements)) {
+                visit(child);
+            }
+            break;
+        case NodeKind::FunctionDeclaration:
+            visitIfPresent(get<FlatFunctionDeclaration>(id).body);
+            break;
+        case NodeKind::FunctionCall:
+            for (const FlatNodeId child : getChildren(get<FlatFunctionCall>(id).arguments)) {
+                visit(child);
+            }
+            break;
+        case NodeKind::VariableDeclaration:
+            visitIfPresent(get<FlatVariableDeclaration>(id).initializer);
+            break;
+        case NodeKind::BinaryOperation:
+            visitIfPresent(get<FlatBinaryOperation>(id).left);
+            visitIfPresent(get<FlatBinaryOperation>(id).right);
+            break;
+        case NodeKind::UnaryOperation:
+            visitIfPresent(get<FlatUnaryOperation>(id).operand);
+            break;
+        case NodeKind::IfStatement:
+            visitIfPresent(get<FlatIfStatement>(id).condition);
+            visitIfPresent(get<FlatIfStatement>(id).thenBranch);
+            visitIfPresent(get<FlatIfStatement>(id).elseBranch);
+            break;
+        case NodeKind::WhileLoop:
+            visitIfPresent(get<FlatWhileLoop>(id).condition);
+            visitIfPresent(get<FlatWhileLoop>(id).body);
+            break;
+        case NodeKind::ReturnStatement:
+            visitIfPresent(get<FlatReturnStatement>(id).expression);
+            break;
+        case NodeKind::ExpressionStatement:
+            visitIfPresent(get<FlatExpressionStatement>(id).expression);
+            break;
+        case NodeKind::Assignment:
+            visitIfPresent(get<FlatAssignment>(id).value);
+            break;
+        case NodeKind::Literal:
+        case NodeKind::Reference:
+        case NodeKind::Error:
+            break;
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Value of a numeric literal, converted once by the lexer and carried by its token and Literal node.
+// The kind of the token or node tells the members apart: integer for Integer literals, floating for Float literals.
+union NumberValue {
+    std::int64_t integer;
+    double       floating;
+};
@@ -2,163 +2,207 @@
 
 #include <algorithm>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 #include "AbstractSyntaxTree.h"
+#include "Diagnostics.h"
 #include "Tokenizer.h"
 
 class Parser {
 public:
-    Parser();
-    // Main parse function
-    std::unique_ptr<Program> parse(std::vector<Token> tokens);
+    // Without a diagnostics sink the first syntax error is thrown as a std::runtime_error. With one, errors are
+    // recorded and the parser recovers in panic mode: it skips to the next ';', '}' or top-level declaration,
+    // leaves an ErrorNode in place of what failed to parse and goes on, so one pass reports every syntax error
+    // without unwinding.
+    explicit Parser(Diagnostics *diagnostics = nullptr);
+    // Main parse function, pulls tokens from the stream as they are lexed
+    std::unique_ptr<Program> parse(TokenStream &tokens);
+    // Convenience wrapper for an already materialized token store
+    std::unique_ptr<Program> parse(const TokenStore &tokens);
+
+    // Parses the top-level declarations on up to threads workers (0: one per hardware thread), each into its own
+    // arena, and assembles them in source order. Declarations are found by brace matching before parsing. Small
+    // inputs and inputs with a syntax error are parsed serially, so errors are reported exactly like parse() does.
+    std::unique_ptr<Program> parseParallel(const TokenStore &tokens, unsigned int threads = 0);
+
+    // Incremental parse after Tokenizer::relex changed the tokens in the range: only the top-level declarations the
+    // change touches (and those with syntax errors) are parsed again, the others are moved into the result as they
+    // are, so node identities of untouched functions stay stable. The tokens have to belong to the interner the
+    // program was parsed with. The result owns the arenas of the previous program, the memory of replaced
+    // declarations stays allocated and is counted in Program::deadBytes until the caller compacts the tree. A change
+    // of the program header falls back to a full parse.
+    std::unique_ptr<Program> reparse(std::unique_ptr<Program> program, const TokenStore &tokens,
+                                     const TokenRange &changed);
+
+    // Copies the tree into a single fresh arena, so the arenas of the given program and every declaration reparse
+    // replaced in them can be released. Every node of the copy is new: callers that keep anything keyed on nodes
+    // drop it with the old program. Compacting once Program::needsCompaction() holds, each copy follows edits that
+    // replaced at least as many bytes, so an edit session takes memory in proportion to the tree and time in
+    // proportion to the edits.
+    static std::unique_ptr<Program> compact(const Program &program);
 
 private:
-    std::vector<Token> m_tokens;
-    std::size_t        m_current_index = 0;
+    // Below this many tokens per worker the thread start-up costs more than the parallel parse saves
+    static constexpr std::size_t MIN_TOKENS_PER_WORKER = 64 * 1024;
+
+    TokenStream *m_tokens = nullptr;
+    Token        m_previous;
+    AstArena    *m_arena = nullptr;
+    Diagnostics *m_diagnostics = nullptr;
+    ErrorNode   *m_panic = nullptr; // the error being recovered from, further errors are not reported until then
+    std::size_t  m_consumed = 0;    // tokens consumed from the current stream, gives token indices of declarations
+    std::size_t  m_errorCount = 0;  // errors reported to the sink
+
+    // An operator, parenthesis or call whose operand is being parsed by parseExpression
+    struct OpenExpression {
+        enum class Kind : std::uint8_t { Prefix, Binary, Group, Call };
+
+        Kind             kind;
+        std::uint8_t     minimumPower;   // of the expression the construct is part of, restored when it is closed
+        OperatorKind     operatorKind{}; // of a prefix or binary operator
+        AbstractNode    *left = nullptr; // left operand of a binary operator
+        std::string_view name{};         // callee of a call
+        SymbolId         symbol = INVALID_SYMBOL;
+        std::size_t      mark = 0; // m_nodeStack size before the arguments of a call
+    };
+
+    // A block parseBlock is collecting the statements of, with the if or while statement it belongs to
+    struct OpenBlock {
+        enum class Kind : std::uint8_t { Body, Then, Else, Loop };
+
+        Kind          kind;
+        std::size_t   mark; // m_nodeStack size before the statements
+        AbstractNode *condition = nullptr;
+        Block        *thenBranch = nullptr;
+    };
+
+    // Scratch stacks the children of open lists are collected on, a finished list is copied into the arena with
+    // its final size and popped. Nested lists push above their parent's children, so one stack serves all levels.
+    std::vector<AbstractNode *>                 m_nodeStack;
+    std::vector<FunctionDeclaration::Parameter> m_parameterStack;
+
+    // Constructs still open in the expression and the blocks being parsed. Nesting is kept on these instead of the
+    // native stack, so its depth is only limited by heap memory.
+    std::vector<OpenExpression> m_expressionStack;
+    std::vector<OpenBlock>      m_blockStack;
 
     // --------------------- Parsing functions --------------------- //
 
-    std::unique_ptr<Program>             parseProgram();
-    std::unique_ptr<Block>               parseBlock();
-    std::unique_ptr<AbstractNode>        parseDeclaration();
-    std::unique_ptr<AbstractNode>        parseStatement();
-    std::unique_ptr<IfStatement>         parseIfStatement();
-    std::unique_ptr<WhileLoop>           parseWhileLoop();
-    std::unique_ptr<ReturnStatement>     parseReturnStatement();
-    std::unique_ptr<AbstractNode>        parseExpression();
-    std::unique_ptr<AbstractNode>        parsePrimaryExpression();
-    std::unique_ptr<AbstractNode>        parseUnaryExpression();
-    std::unique_ptr<VariableDeclaration> parseVariableDeclaration();
-    std::unique_ptr<FunctionCall>        parseFunctionCallExpr();
-    std::unique_ptr<FunctionDeclaration> parseFunctionDeclaration();
-    std::unique_ptr<AbstractNode>        parseBinaryOperation(int precedence = 0);
-    std::unique_ptr<Assignment>          parseAssignment();
+    // Functions that contain a block return nullptr if an error occurs before it, the enclosing list replaces a
+    // failed element by the ErrorNode of the error and synchronizes
+    std::unique_ptr<Program> parseProgram();
+    Block                   *parseBlock();
+    AbstractNode            *parseDeclaration();
+    AbstractNode            *parseDeclaration(const TokenStore &tokens, std::size_t begin, std::size_t end);
+    void                     parseTopLevelDeclaration(std::size_t streamStart, std::vector<DeclarationTokens> &ranges);
+    AbstractNode            *parseStatement();
+    ReturnStatement         *parseReturnStatement();
+    AbstractNode            *parseExpression();
+    AbstractNode            *parsePrimaryExpression();
+    VariableDeclaration     *parseVariableDeclaration();
+    FunctionCall            *parseFunctionCallExpr();
+    FunctionDeclaration     *parseFunctionDeclaration();
+    Assignment              *parseAssignment();
+
+    // Steps of parseBlock: opening an if or while statement consumes it up to its '{' and pushes its block, closing
+    // a block after its '}' finishes the statement it belongs to, or opens the else block
+    void openBlockStatement();
+    void closeBlock(Block *block);
+
+    // Adds a statement to the innermost open block, a failed one (nullptr) is replaced by the ErrorNode of the error
+    // and the parser synchronizes
+    void addStatement(AbstractNode *statement);
+
+    // ---------------------- Error recovery ----------------------- //
+
+    // Skips the rest of a failed statement: up to and including a ';' or a block closed at the level of the
+    // statement, or up to the '}' of the enclosing block or a 'func' keyword
+    void synchronizeStatement();
+
+    // Skips to the start of the next top-level declaration after the body of the failed one, at least one token
+    // if the failed declaration consumed none
+    void synchronizeDeclaration(bool skipFirst);
+
+    [[nodiscard]] bool startsDeclaration() const;
 
     // ------------------ Parsing Helper Functions ------------------ //
 
     void advance();
 
-    // Advances if the current token matches, otherwise throws an error
-    void consume(TokenType type);
-    void consume(const std::string &value);
-    void consume(TokenType type, const std::string &value);
+    // Moves the nodes pushed since mark into an arena array
+    auto popNodes(std::size_t mark) -> std::span<AbstractNode *>;
 
-    // Returns true if the current token matches
-    [[nodiscard]] bool match(TokenType type) const;
-    [[nodiscard]] bool match(const std::string &value) const;
-    [[nodiscard]] bool match(TokenType type, const std::string &value) const;
+    // Advances and returns true if the current token is of the kind, otherwise reports an error and returns false
+    bool consume(TokenKind kind);
 
-    // Returns tokens without advancing
-    [[nodiscard]] Token              peek() const;
-    [[nodiscard]] Token              peekNext() const;
-    [[nodiscard]] Token              peekPrevious() const;
-    [[nodiscard]] std::vector<Token> peekUntilEOL();
+    // Returns true if the current token is of the kind, a single byte compare
+    [[nodiscard]] bool match(TokenKind kind) const;
 
-    [[nodiscard]] bool isAtEnd() const;
+    // Return tokens without advancing. The references point into the lookahead of the token stream and stay valid
+    // until the parser advances, copy the token (a few words, no allocation) to keep it longer.
+    [[nodiscard]] const Token &peek() const;
+    [[nodiscard]] const Token &peekNext() const;
+    [[nodiscard]] const Token &peekPrevious() const;
 
-    [[noreturn]] void throwError(const std::string &message) const;
+    [[nodiscard]] bool isAtEnd() const;
 
-    // ------------------ Static Helper Functions ------------------ //
+    // Spelling of an identifier from the interner rather than the source, so the tree stays valid when the source
+    // buffer is replaced after an edit. Other tokens (only found in declarations with errors) keep their source text.
+    [[nodiscard]] auto spellingOf(const Token &token) const -> std::string_view;
 
-    [[nodiscard]] static bool isBinaryOperator(const Token &peek);
-    [[nodiscard]] static bool isBinaryOperation(const std::vector<Token> &line);
-    [[nodiscard]] static int  getOperatorPrecedence(const std::string &string);
-};
+    // Throws without a diagnostics sink. With one, the first error since the last synchronization is recorded and
+    // the ErrorNode standing for it is returned. The message has to be static text.
+    ErrorNode *reportError(std::string_view message);
 
-inline auto Parser::peek() const -> Token { return m_tokens[m_current_index]; }
+    [[noreturn]] void throwError(const std::string &message) const;
 
-inline auto Parser::peekNext() const -> Token { return m_tokens[m_current_index + 1]; }
+    // "expected <kind>" as static text
+    static auto expectedMessage(TokenKind kind) -> std::string_view;
+};
 
-inline auto Parser::peekPrevious() const -> Token { return m_tokens[m_current_index - 1]; }
+inline auto Parser::peek() const -> const Token & { return m_tokens->peek(); }
 
-inline auto Parser::peekUntilEOL() -> std::vector<Token> {
-    std::vector<Token> tokens;
-    const std::size_t  index = m_current_index;
+inline auto Parser::peekNext() const -> const Token & { return m_tokens->peek(1); }
 
-    while (!isAtEnd() && peek().getValue() != ";") {
-        tokens.push_back(peek());
-        ++m_current_index;
-    }
-    m_current_index = index;
-    return tokens;
-}
+inline auto Parser::peekPrevious() const -> const Token & { return m_previous; }
 
 inline void Parser::advance() {
     if (isAtEnd()) {
-        throwError("cannot advance past end of token stream");
+        reportError("cannot advance past end of token stream");
+        return;
     }
-    ++m_current_index;
+    m_previous = m_tokens->next();
+    m_consumed++;
 }
 
-inline auto Parser::isAtEnd() const -> bool { return m_current_index >= m_tokens.size(); }
-
-inline auto Parser::match(const TokenType type) const -> bool {
-    return !isAtEnd() && m_tokens[m_current_index].getType() == type;
+inline auto Parser::popNodes(const std::size_t mark) -> std::span<AbstractNode *> {
+    const auto nodes = m_arena->copyArray(std::span<AbstractNode *const>(m_nodeStack).subspan(mark));
+    m_nodeStack.resize(mark);
+    return nodes;
 }
 
-inline auto Parser::match(const std::string &value) const -> bool {
-    return !isAtEnd() && m_tokens[m_current_index].getValue() == value;
-}
+inline auto Parser::isAtEnd() const -> bool { return m_tokens->peek().getKind() == TokenKind::EndOfFile; }
 
-inline auto Parser::match(const TokenType type, const std::string &value) const -> bool {
-    return !isAtEnd() && m_tokens[m_current_index].getType() == type && m_tokens[m_current_index].getValue() == value;
+inline auto Parser::spellingOf(const Token &token) const -> std::string_view {
+    const SymbolId symbol = token.getSymbol();
+    return symbol == INVALID_SYMBOL ? token.getValue() : m_tokens->getInterner().getSpelling(symbol);
 }
 
-inline void Parser::consume(const TokenType type) {
-    match(type) ? advance() : throwError("expected token of type " + tokenTypeToString(type));
-}
+inline auto Parser::match(const TokenKind kind) const -> bool { return peek().getKind() == kind; }
 
-inline void Parser::consume(const std::string &value) {
-    match(value) ? advance() : throwError("expected token with value " + value);
-}
-
-inline void Parser::consume(const TokenType type, const std::string &value) {
-    match(type, value) ? advance()
-                       : throwError("expected token of type " + tokenTypeToString(type) + " with value " + value);
+inline auto Parser::consume(const TokenKind kind) -> bool {
+    // while panicking nothing is consumed, so synchronization starts at the token the error was found at
+    if (m_panic != nullptr || !match(kind)) {
+        reportError(expectedMessage(kind));
+        return false;
+    }
+    advance();
+    return true;
 }
 
 inline void Parser::throwError(const std::string &message) const {
-    throw std::runtime_error("Parse error: " + message + " at line " + std::to_string(peek().getPosition().getLine()) +
-                             " column " + std::to_string(peek().getPosition().getColumn()) + " (token: \"" +
-                             peek().getValue() + "\")");
-}
-
-inline auto Parser::isBinaryOperation(const std::vector<Token> &line) -> bool {
-    return std::ranges::any_of(line, [](const Token &token) { return BINARY_OPERATORS.contains(token.getValue()); });
-}
-
-inline auto Parser::isBinaryOperator(const Token &peek) -> bool { return BINARY_OPERATORS.contains(peek.getValue()); }
-
-inline auto Parser::getOperatorPrecedence(const std::string &op) -> int {
-    static const std::unordered_map<std::string, int> PRECEDENCE_TABLE = {
-        {"=", 1},   // Assignment
-        {"||", 2},  // Logical OR
-        {"&&", 3},  // Logical AND
-        {"|", 4},   // Bitwise OR
-        {"^", 5},   // Bitwise XOR
-        {"&", 6},   // Bitwise AND
-        {"==", 7},  // Equality
-        {"!=", 7},  // Inequality
-        {"<", 8},   // Relational
-        {">", 8},   // Relational
-        {"<=", 8},  // Relational
-        {">=", 8},  // Relational
-        {"<<", 9},  // Bitwise shift left
-        {">>", 9},  // Bitwise shift right
-        {"+", 10},  // Addition
-        {"-", 10},  // Subtraction
-        {"*", 11},  // Multiplication
-        {"/", 11},  // Division
-        {"%", 11},  // Modulo
-        {"-", 12},  // Unary negation (handled separately in unary parsing)
-        {"!", 12},  // Logical NOT (handled separately in unary parsing)
-    };
-
-    const auto iterator = PRECEDENCE_TABLE.find(op);
-    if (iterator != PRECEDENCE_TABLE.end()) {
-        return iterator->second;
-    }
-
-    throw std::runtime_error("invalid operator " + op);
+    const Position position = m_tokens->getSource().getPosition(peek().getOffset());
+    throw std::runtime_error("Parse error: " + message + " at line " + std::to_string(position.getLine()) + " column " +
+                             std::to_string(position.getColumn()) + " (token: \"" + std::string(peek().getValue()) +
+                             "\")");
 }
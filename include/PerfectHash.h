@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+// Collision-free hash table over a fixed set of short string keys, built entirely at compile time.
+// The hash mixes the length and the first, second and last byte of a key with a multiplier that the constructor
+// searches for, a lookup is one multiply, a shift and a single compare against the only candidate key.
+template <typename Value, std::size_t N, unsigned int TableBits>
+class PerfectHashTable {
+public:
+    using Entry = std::pair<std::string_view, Value>;
+
+    static constexpr std::size_t TABLE_SIZE = std::size_t{1} << TableBits;
+    static_assert(N < TABLE_SIZE, "PerfectHashTable: the table needs more slots than keys");
+
+    constexpr explicit PerfectHashTable(const std::array<Entry, N> &entries);
+
+    [[nodiscard]] constexpr auto find(std::string_view key) const -> std::optional<Value>;
+
+    // False if no multiplier separates all keys, tables are checked with a static_assert so this fails the build
+    [[nodiscard]] constexpr auto isPerfect() const -> bool;
+
+private:
+    static constexpr std::uint32_t FIRST_MULTIPLIER = 0x9E3779B1;
+    static constexpr unsigned int  MAX_ATTEMPTS = 1 << 16;
+
+    std::array<Entry, N>                 m_entries;
+    std::array<std::uint8_t, TABLE_SIZE> m_slots{}; // index + 1 into m_entries, 0 for an empty slot
+    std::uint32_t                        m_multiplier = 0;
+
+    static constexpr auto fingerprint(std::string_view key) -> std::uint32_t;
+    constexpr auto        slotOf(std::string_view key) const -> std::size_t;
+};
+
+template <typename Value, std::size_t N, unsigned int TableBits>
+constexpr PerfectHashTable<Value, N, TableBits>::PerfectHashTable(const std::array<Entry, N> &entries) :
+    m_entries(entries) {
+    static_assert(N < 0xFF, "PerfectHashTable: slots store 8-bit entry indices");
+
+    // try odd multipliers until every key lands in its own slot
+    for (unsigned int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+        m_multiplier = FIRST_MULTIPLIER + 2 * attempt;
+        m_slots = {};
+
+        bool collision = false;
+        for (std::size_t index = 0; index < N && !collision; ++index) {
+            std::uint8_t &slot = m_slots[slotOf(m_entries[index].first)];
+            collision = slot != 0;
+            slot = static_cast<std::uint8_t>(index + 1);
+        }
+        if (!collision) {
+            return;
+        }
+    }
+    m_multiplier = 0;
+}
+
+template <typename Value, std::size_t N, unsigned int TableBits>
+constexpr auto PerfectHashTable<Value, N, TableBits>::find(const std::string_view key) const -> std::optional<Value> {
+    const std::uint8_t slot = m_slots[slotOf(key)];
+    if (slot == 0 || m_entries[slot - 1].first != key) {
+        return std::nullopt;
+    }
+    return m_entries[slot - 1].second;
+}
+
+template <typename Value, std::size_t N, unsigned int TableBits>
+constexpr auto PerfectHashTable<Value, N, TableBits>::isPerfect() const -> bool {
+    return m_multiplier != 0;
+}
+
+template <typename Value, std::size_t N, unsigned int TableBits>
+constexpr auto PerfectHashTable<Value, N, TableBits>::fingerprint(const std::string_view key) -> std::uint32_t {
+    if (key.empty()) {
+        return 0;
+    }
+    const auto byte = [&](const std::size_t index) {
+        return static_cast<std::uint32_t>(static_cast<unsigned char>(key[index]));
+    };
+    return static_cast<std::uint32_t>(key.size() & 0xFF) | byte(0) << 8 | byte(key.size() > 1 ? 1 : 0) << 16 |
+           byte(key.size() - 1) << 24;
+}
+
+template <typename Value, std::size_t N, unsigned int TableBits>
+constexpr auto PerfectHashTable<Value, N, TableBits>::slotOf(const std::string_view key) const -> std::size_t {
+    return (fingerprint(key) * m_multiplier) >> (32 - TableBits);
+}
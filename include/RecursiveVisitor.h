@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+
+#include "AbstractSyntaxTree.h"
+#include "AstWalker.h"
+
+// Statically dispatched tree traversal, the counterpart of the virtual Visitor for passes that walk whole trees.
+// A pass derives from RecursiveVisitor<Pass> and defines the hooks of the nodes it cares about, under the same name
+// and signature as below: visitX(X &) is called before the children of a node and returns whether to walk them,
+// leaveX(X &) after them. Hooks are found at compile time, there is one switch over the kind tag per node and no
+// virtual call, so the compiler can inline hooks and child lists into the walk.
+// The walk recurses natively up to MAX_NATIVE_DEPTH levels and hands deeper subtrees to an AstWalker, so deep
+// trees cost heap and not native stack.
+template <typename Derived>
+class RecursiveVisitor {
+public:
+    static constexpr std::size_t MAX_NATIVE_DEPTH = 256;
+
+    // Walks the tree below root in pre-order, root included
+    void traverse(AbstractNode &root);
+
+    // Default hooks: walk every child, nothing to do on the way back
+
+    auto visitProgram(Program &) -> bool { return true; }
+    auto visitBlock(Block &) -> bool { return true; }
+    auto visitFunctionDeclaration(FunctionDeclaration &) -> bool { return true; }
+    auto visitFunctionCall(FunctionCall &) -> bool { return true; }
+    auto visitVariableDeclaration(VariableDeclaration &) -> bool { return true; }
+    auto visitLiteral(Literal &) -> bool { return true; }
+    auto visitReference(Reference &) -> bool { return true; }
+    auto visitBinaryOperation(BinaryOperation &) -> bool { return true; }
+    auto visitUnaryOperation(UnaryOperation &) -> bool { return true; }
+    auto visitIfStatement(IfStatement &) -> bool { return true; }
+    auto visitWhileLoop(WhileLoop &) -> bool { return true; }
+    auto visitReturnStatement(ReturnStatement &) -> bool { return true; }
+    auto visitExpressionStatement(ExpressionStatement &) -> bool { return true; }
+    auto visitAssignment(Assignment &) -> bool { return true; }
+    auto visitError(ErrorNode &) -> bool { return true; }
+
+    void leaveProgram(Program &) {}
+    void leaveBlock(Block &) {}
+    void leaveFunctionDeclaration(FunctionDeclaration &) {}
+    void leaveFunctionCall(FunctionCall &) {}
+    void leaveVariableDeclaration(VariableDeclaration &) {}
+    void leaveLiteral(Literal &) {}
+    void leaveReference(Reference &) {}
+    void leaveBinaryOperation(BinaryOperation &) {}
+    void leaveUnaryOperation(UnaryOperation &) {}
+    void leaveIfStatement(IfStatement &) {}
+    void leaveWhileLoop(WhileLoop &) {}
+    void leaveReturnStatement(ReturnStatement &) {}
+    void leaveExpressionStatement(ExpressionStatement &) {}
+    void leaveAssignment(Assignment &) {}
+    void leaveError(ErrorNode &) {}
+
+private:
+    AstWalker m_walker; // for the subtrees below MAX_NATIVE_DEPTH
+
+    auto derived() -> Derived & { return static_cast<Derived &>(*this); }
+
+    void traverseNode(AbstractNode &node, std::size_t depth);
+    template <typename Node>
+    void traverseAs(Node &node, std::size_t depth);
+    void traverseDeep(AbstractNode &root);
+
+    // The hooks of a node class, by overload
+    auto enter(Program &node) -> bool { return derived().visitProgram(node); }
+    auto enter(Block &node) -> bool { return derived().visitBlock(node); }
+    auto enter(FunctionDeclaration &node) -> bool { return derived().visitFunctionDeclaration(node); }
+    auto enter(FunctionCall &node) -> bool { return derived().visitFunctionCall(node); }
+    auto enter(VariableDeclaration &node) -> bool { return derived().visitVariableDeclaration(node); }
+    auto enter(Literal &node) -> bool { return derived().visitLiteral(node); }
+    auto enter(Reference &node) -> bool { return derived().visitReference(node); }
+    auto enter(BinaryOperation &node) -> bool { return derived().visitBinaryOperation(node); }
+    auto enter(UnaryOperation &node) -> bool { return derived().visitUnaryOperation(node); }
+    auto enter(IfStatement &node) -> bool { return derived().visitIfStatement(node); }
+    auto enter(WhileLoop &node) -> bool { return derived().visitWhileLoop(node); }
+    auto enter(ReturnStatement &node) -> bool { return derived().visitReturnStatement(node); }
+    auto enter(ExpressionStatement &node) -> bool { return derived().visitExpressionStatement(node); }
+    auto enter(Assignment &node) -> bool { return derived().visitAssignment(node); }
+    auto enter(ErrorNode &node) -> bool { return derived().visitError(node); }
+
+    void leave(Program &node) { derived().leaveProgram(node); }
+    void leave(Block &node) { derived().leaveBlock(node); }
+    void leave(FunctionDeclaration &node) { derived().leaveFunctionDeclaration(node); }
+    void leave(FunctionCall &node) { derived().leaveFunctionCall(node); }
+    void leave(VariableDeclaration &node) { derived().leaveVariableDeclaration(node); }
+    void leave(Literal &node) { derived().leaveLiteral(node); }
+    void leave(Reference &node) { derived().leaveReference(node); }
+    void leave(BinaryOperation &node) { derived().leaveBinaryOperation(node); }
+    void leave(UnaryOperation &node) { derived().leaveUnaryOperation(node); }
+    void leave(IfStatement &node) { derived().leaveIfStatement(node); }
+    void leave(WhileLoop &node) { derived().leaveWhileLoop(node); }
+    void leave(ReturnStatement &node) { derived().leaveReturnStatement(node); }
+    void leave(ExpressionStatement &node) { derived().leaveExpressionStatement(node); }
+    void leave(Assignment &node) { derived().leaveAssignment(node); }
+    void leave(ErrorNode &node) { derived().leaveError(node); }
+};
+
+template <typename Derived>
+void RecursiveVisitor<Derived>::traverse(AbstractNode &root) {
+    traverseNode(root, 0);
+}
+
+template <typename Derived>
+void RecursiveVisitor<Derived>::traverseNode(AbstractNode &node, const std::size_t depth) {
+    if (depth == MAX_NATIVE_DEPTH) [[unlikely]] {
+        traverseDeep(node);
+        return;
+    }
+    dispatchNode(node, [this, depth](auto &typed) { traverseAs(typed, depth); });
+}
+
+template <typename Derived>
+template <typename Node>
+void RecursiveVisitor<Derived>::traverseAs(Node &node, const std::size_t depth) {
+    if (enter(node)) {
+        forEachChildOf(node, [this, depth](AbstractNode *child) { traverseNode(*child, depth + 1); });
+    }
+    leave(node);
+}
+
+template <typename Derived>
+void RecursiveVisitor<Derived>::traverseDeep(AbstractNode &root) {
+    m_walker.walk(
+            root, [this](AbstractNode &node, AbstractNode *, std::size_t) {
+                return dispatchNode(node, [this](auto &typed) { return enter(typed); });
+            },
+            [this](AbstractNode &node, AbstractNode *) { dispatchNode(node, [this](auto &typed) { leave(typed); }); });
+}
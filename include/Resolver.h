@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "AbstractSyntaxTree.h"
+
+// Number of slots a resolution handed out, code generation sizes its tables by them
+struct Resolution {
+    std::uint32_t variableCount = 0; // variables and parameters
+    std::uint32_t functionCount = 0;
+};
+
+// Name resolution, run between parsing and code generation. Binds every Reference and Assignment to the slot of the
+// variable or parameter it names and every FunctionCall to the slot of its function, following lexical scopes: the
+// program, each function with its parameters, and each block, which includes loop and branch bodies.
+// A declaration is visible from its end to the end of its scope and shadows the ones of the same name outside. Each
+// declaration gets a slot of its own, so code generation keeps what it binds to declarations in plain arrays and
+// nothing declared in one function is visible in another. Calls of undeclared names stay unresolved, they are left
+// to the built-in functions of the code generator.
+class Resolver {
+public:
+    // Resolves the whole program, throws a std::runtime_error naming the first variable that isn't in scope
+    static auto resolve(Program &program) -> Resolution;
+
+private:
+    class Builder;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+// Vectorized byte scanners used by the Tokenizer's hot loops
+// Each scanner looks at 32 (AVX2) or 16 (SSE2) bytes per step and falls back to a scalar loop for the tail,
+// or for the whole range on targets without SSE2. All of them return end if no byte stops the scan.
+namespace scanner {
+    // Returns the first byte that is not whitespace (' ', '\t', '\r', '\n', '\0')
+    [[nodiscard]] auto skipWhitespace(const char *begin, const char *end) -> const char *;
+
+    // Returns the first '\n', used to skip line comments
+    [[nodiscard]] auto findLineEnd(const char *begin, const char *end) -> const char *;
+
+    // Returns the first byte that cannot continue an identifier ([A-Za-z0-9_])
+    [[nodiscard]] auto skipIdentifier(const char *begin, const char *end) -> const char *;
+
+    // Counts the '\n' bytes in the range, used to fix up line numbers after a skip
+    [[nodiscard]] auto countNewlines(const char *begin, const char *end) -> std::size_t;
+
+    // Name of the instruction set the scanners were compiled for
+    [[nodiscard]] auto instructionSet() -> const char *;
+} // namespace scanner
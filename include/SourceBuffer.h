@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <llvm/Support/MemoryBuffer.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Represents a position in the source code
+class Position {
+public:
+    Position() = default;
+    Position(unsigned int line, unsigned int column);
+
+    [[nodiscard]] auto getLine() const -> unsigned int;
+    [[nodiscard]] auto getColumn() const -> unsigned int;
+
+private:
+    unsigned int m_line = 0;
+    unsigned int m_column = 0;
+};
+
+// Read-only view of a source file that stays alive for the whole compilation.
+// Tokens, the parser and the code generator refer into this buffer instead of copying text.
+// Offsets into the buffer are 32-bit, positions are computed from them on demand.
+class SourceBuffer {
+public:
+    // Maps the file into memory (llvm::MemoryBuffer uses mmap where the platform and file size allow it)
+    static auto fromFile(const std::string &filepath) -> SourceBuffer;
+
+    // Wraps a caller-owned buffer without copying, the caller must keep it alive
+    static auto fromMemory(std::string_view text, const std::string &name = "<memory>") -> SourceBuffer;
+
+    [[nodiscard]] auto getText() const -> std::string_view;
+    [[nodiscard]] auto getName() const -> std::string_view;
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    // Line and column (both 1-based) of a byte offset, the newline index is built on the first call
+    [[nodiscard]] auto getPosition(std::uint32_t offset) const -> Position;
+
+private:
+    explicit SourceBuffer(std::unique_ptr<llvm::MemoryBuffer> buffer);
+
+    // Offsets of the first byte of every line, only needed for diagnostics so it is built lazily
+    struct LineIndex {
+        std::once_flag             built;
+        std::vector<std::uint32_t> lineStarts;
+    };
+
+    std::unique_ptr<llvm::MemoryBuffer> m_buffer;
+    std::unique_ptr<LineIndex>          m_lineIndex;
+};
+
+inline auto SourceBuffer::getText() const -> std::string_view {
+    return {m_buffer->getBufferStart(), m_buffer->getBufferSize()};
+}
+
+inline auto SourceBuffer::getName() const -> std::string_view {
+    const llvm::StringRef name = m_buffer->getBufferIdentifier();
+    return {name.data(), name.size()};
+}
+
+inline auto SourceBuffer::size() const -> std::size_t { return m_buffer->getBufferSize(); }
+
+inline auto Position::getLine() const -> unsigned int { return m_line; }
+
+inline auto Position::getColumn() const -> unsigned int { return m_column; }
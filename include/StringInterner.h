@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Allocator.h>
+#include <string_view>
+#include <vector>
+
+// Dense 32-bit id of an interned identifier, usable as an array index
+using SymbolId = std::uint32_t;
+
+constexpr SymbolId INVALID_SYMBOL = std::numeric_limits<SymbolId>::max();
+
+// Assigns every distinct identifier spelling a SymbolId, owned by the compilation.
+// Spellings are stored once and stay valid for the lifetime of the interner, so the AST can keep views into it.
+class StringInterner {
+public:
+    StringInterner() = default;
+    StringInterner(const StringInterner &) = delete;
+    StringInterner &operator=(const StringInterner &) = delete;
+
+    // Returns the id of the spelling, assigning the next free id if it has not been seen before
+    auto intern(std::string_view spelling) -> SymbolId;
+
+    // Returns the id of the spelling or INVALID_SYMBOL, never assigns a new id
+    [[nodiscard]] auto find(std::string_view spelling) const -> SymbolId;
+
+    [[nodiscard]] auto getSpelling(SymbolId id) const -> std::string_view;
+    [[nodiscard]] auto size() const -> std::size_t;
+
+private:
+    llvm::StringMap<SymbolId, llvm::BumpPtrAllocator> m_ids;
+    std::vector<std::string_view>                     m_spellings; // indexed by SymbolId, views into m_ids keys
+};
+
+inline auto StringInterner::getSpelling(const SymbolId id) const -> std::string_view { return m_spellings[id]; }
+
+inline auto StringInterner::size() const -> std::size_t { return m_spellings.size(); }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <llvm/ADT/DenseMap.h>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "AbstractSyntaxTree.h"
+
+// 128-bit hash of the structure of a subtree: node kinds, operators, literal payloads, names and flags, in tree
+// order. Source positions and symbol ids don't go in, so equal subtrees hash equal across edits, compilations and
+// hosts. Not cryptographic, it detects changes but doesn't stand up to crafted collisions.
+struct StructuralHash {
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    auto operator==(const StructuralHash &) const -> bool = default;
+
+    // For hash containers keyed by structural hashes, the bits are already mixed
+    struct Hasher {
+        auto operator()(const StructuralHash &hash) const -> std::size_t { return hash.low; }
+    };
+};
+
+// Lets DenseMap key by structural hashes, the two reserved keys are values finish() practically never returns
+template <>
+struct llvm::DenseMapInfo<StructuralHash> {
+    static auto getEmptyKey() -> StructuralHash { return {~std::uint64_t{0}, ~std::uint64_t{0}}; }
+    static auto getTombstoneKey() -> StructuralHash { return {~std::uint64_t{0} - 1, ~std::uint64_t{0}}; }
+    static auto getHashValue(const StructuralHash &hash) -> unsigned { return static_cast<unsigned>(hash.low); }
+    static auto isEqual(const StructuralHash &left, const StructuralHash &right) -> bool { return left == right; }
+};
+
+// Folds a sequence of 64-bit words into a StructuralHash. The words go through two multiply-rotate lanes with
+// different constants, the high lane also takes in the low one, and both are finalized into each other.
+class StructuralHashBuilder {
+public:
+    explicit StructuralHashBuilder(NodeKind kind);
+
+    void add(std::uint64_t word);
+    void add(std::string_view text);
+    void add(const StructuralHash &hash);
+
+    [[nodiscard]] auto finish() const -> StructuralHash;
+
+private:
+    std::uint64_t m_low;
+    std::uint64_t m_high;
+    std::uint64_t m_count = 0;
+};
+
+// Structural hashes of a Program, computed bottom-up in one walk. Every function declaration gets the hash of its
+// body and of the whole declaration, every expression subtree (call, literal, reference, operation) its own hash.
+// Structural hashes compare names, so x + 1 hashes the same in every function; they tell whether code changed, not
+// what it refers to. Canonical expressions go by what the names are bound to: expressions of equal structure whose
+// references and calls resolve to the same declarations share one canonical node, the first in tree order. That
+// needs a resolved program (Resolver::resolve), an unresolved reference is only canonical to itself. Equal
+// expressions read the same variables, not necessarily the same values, assignments between them aren't tracked.
+// The hashes refer to the nodes of the program, which has to outlive them.
+class StructuralHashes {
+public:
+    struct Function {
+        const FunctionDeclaration *node;
+        StructuralHash             body;        // the body block alone
+        StructuralHash             declaration; // name, parameters, return type and body
+    };
+
+    static auto compute(const Program &program) -> StructuralHashes;
+
+    // Hash of the whole program
+    [[nodiscard]] auto getProgramHash() const -> StructuralHash;
+
+    // Every function declaration in tree order
+    [[nodiscard]] auto getFunctions() const -> std::span<const Function>;
+
+    // Hash of an expression subtree of the program, nullptr if the node isn't one
+    [[nodiscard]] auto findExpressionHash(const AbstractNode &expression) const -> const StructuralHash *;
+
+    // First expression of the program with the same structure and bindings, the node itself for the first of its kind
+    [[nodiscard]] auto getCanonicalExpression(const AbstractNode &expression) const -> const AbstractNode *;
+
+    // Expression subtrees and how many of them have distinct canonical expressions
+    [[nodiscard]] auto getExpressionCount() const -> std::size_t;
+    [[nodiscard]] auto getDistinctExpressionCount() const -> std::size_t;
+
+private:
+    class Builder;
+
+    struct Expression {
+        StructuralHash structure;
+        StructuralHash binding; // structure, with the declarations the names are bound to in place of the names
+    };
+
+    StructuralHash                                       m_program;
+    std::vector<Function>                                m_functions;
+    llvm::DenseMap<const AbstractNode *, Expression>     m_expressions;
+    llvm::DenseMap<StructuralHash, const AbstractNode *> m_canonical; // by binding hash
+};
+
+inline auto StructuralHashes::getProgramHash() const -> StructuralHash { return m_program; }
+
+inline auto StructuralHashes::getFunctions() const -> std::span<const Function> { return m_functions; }
+
+inline auto StructuralHashes::getExpressionCount() const -> std::size_t { return m_expressions.size(); }
+
+inline auto StructuralHashes::getDistinctExpressionCount() const -> std::size_t { return m_canonical.size(); }
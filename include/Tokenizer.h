@@ -1,26 +1,22 @@
 #pragma once
 
-#include <filesystem>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
-#include <set>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-const std::set<std::string> KEYWORDS = {"if",       "else",   "while",   "return", "break",
-                                        "continue", "import", "program", "func"};
-
-const std::set<char> SYMBOLS = {'+', '-', '*', '/', '=', '!', '<', '>', '(', ')', '{', '}',
-                                '[', ']', ';', ',', '.', ':', '&', '|', '^', '~', '.', '%',
-                                '?', '@', '#', '$', '\\', '`'};
-
-const std::set<std::string> LONG_SYMBOLS = {"==", "!=", "<=", ">=", "&&", "||", "->", "<<", ">>", "++", "--"};
-
-const std::set<char> WHITESPACE = {' ', '\t', '\n', '\r', '\0'};
-
-const std::set<std::string> BINARY_OPERATORS = {"+", "-", "*", "/", "==", "!=", "<", ">", "<=", ">=", "&&", "||", "%",
-                                                "<<", ">>", "&", "|", "^"};
-
-const std::set<std::string> UNARY_OPERATORS = {"+", "-", "!", "~", "++", "--"};
+#include "Diagnostics.h"
+#include "NumberValue.h"
+#include "PerfectHash.h"
+#include "SourceBuffer.h"
+#include "StringInterner.h"
 
 enum class TokenType : std::uint8_t {
     Identifier, // Function names, variable names, etc.
@@ -29,71 +25,474 @@ enum class TokenType : std::uint8_t {
     String,     // Double-quoted strings: "example"
     Char,       // Single characters: 'a'
     Keyword,    // Reserved keywords: if, else, while, etc.
-    Symbol      // Operators and symbols: +, -, *, /, =, etc.
+    Symbol,     // Operators and symbols: +, -, *, /, =, etc.
+    EndOfFile   // Returned by token streams once the source is exhausted
 };
 
-// Represents a position in the source code
-class Position {
-public:
-    Position(unsigned int line, unsigned int column);
+// Fine-grained token kind produced by the lexer, every keyword and operator has its own kind
+enum class TokenKind : std::uint8_t {
+    // Literals and names
+    Identifier,
+    Integer,
+    Float,
+    String,
+    Char,
+
+    // Keywords
+    If,
+    Else,
+    While,
+    Return,
+    Break,
+    Continue,
+    Import,
+    Program,
+    Func,
+
+    // Single character symbols
+    Plus,         // +
+    Minus,        // -
+    Star,         // *
+    Slash,        // /
+    Percent,      // %
+    Equal,        // =
+    Bang,         // !
+    Less,         // <
+    Greater,      // >
+    Amp,          // &
+    Pipe,         // |
+    Caret,        // ^
+    Tilde,        // ~
+    LeftParen,    // (
+    RightParen,   // )
+    LeftBrace,    // {
+    RightBrace,   // }
+    LeftBracket,  // [
+    RightBracket, // ]
+    Semicolon,    // ;
+    Comma,        // ,
+    Dot,          // .
+    Colon,        // :
+    Question,     // ?
+    At,           // @
+    Hash,         // #
+    Dollar,       // $
+    Backslash,    // \ (backslash)
+    Backtick,     // `
+
+    // Two character symbols
+    EqualEqual,     // ==
+    BangEqual,      // !=
+    LessEqual,      // <=
+    GreaterEqual,   // >=
+    AmpAmp,         // &&
+    PipePipe,       // ||
+    Arrow,          // ->
+    LessLess,       // <<
+    GreaterGreater, // >>
+    PlusPlus,       // ++
+    MinusMinus,     // --
+
+    EndOfFile,
+};
 
-    [[nodiscard]] auto getLine() const -> unsigned int;
-    [[nodiscard]] auto getColumn() const -> unsigned int;
+constexpr std::size_t TOKEN_KIND_COUNT = static_cast<std::size_t>(TokenKind::EndOfFile) + 1;
+
+static_assert(TOKEN_KIND_COUNT <= 64, "token kind sets are 64-bit masks");
+
+constexpr std::array<std::pair<std::string_view, TokenKind>, 9> KEYWORDS = {{
+    {"if", TokenKind::If},
+    {"else", TokenKind::Else},
+    {"while", TokenKind::While},
+    {"return", TokenKind::Return},
+    {"break", TokenKind::Break},
+    {"continue", TokenKind::Continue},
+    {"import", TokenKind::Import},
+    {"program", TokenKind::Program},
+    {"func", TokenKind::Func},
+}};
+
+static_assert(KEYWORDS.size() ==
+                      static_cast<std::size_t>(TokenKind::Func) - static_cast<std::size_t>(TokenKind::If) + 1,
+              "every keyword kind needs an entry in KEYWORDS");
+
+constexpr std::array<std::pair<std::string_view, TokenKind>, 40> OPERATORS = {{
+    {"+", TokenKind::Plus},
+    {"-", TokenKind::Minus},
+    {"*", TokenKind::Star},
+    {"/", TokenKind::Slash},
+    {"%", TokenKind::Percent},
+    {"=", TokenKind::Equal},
+    {"!", TokenKind::Bang},
+    {"<", TokenKind::Less},
+    {">", TokenKind::Greater},
+    {"&", TokenKind::Amp},
+    {"|", TokenKind::Pipe},
+    {"^", TokenKind::Caret},
+    {"~", TokenKind::Tilde},
+    {"(", TokenKind::LeftParen},
+    {")", TokenKind::RightParen},
+    {"{", TokenKind::LeftBrace},
+    {"}", TokenKind::RightBrace},
+    {"[", TokenKind::LeftBracket},
+    {"]", TokenKind::RightBracket},
+    {";", TokenKind::Semicolon},
+    {",", TokenKind::Comma},
+    {".", TokenKind::Dot},
+    {":", TokenKind::Colon},
+    {"?", TokenKind::Question},
+    {"@", TokenKind::At},
+    {"#", TokenKind::Hash},
+    {"$", TokenKind::Dollar},
+    {"\\", TokenKind::Backslash},
+    {"`", TokenKind::Backtick},
+    {"==", TokenKind::EqualEqual},
+    {"!=", TokenKind::BangEqual},
+    {"<=", TokenKind::LessEqual},
+    {">=", TokenKind::GreaterEqual},
+    {"&&", TokenKind::AmpAmp},
+    {"||", TokenKind::PipePipe},
+    {"->", TokenKind::Arrow},
+    {"<<", TokenKind::LessLess},
+    {">>", TokenKind::GreaterGreater},
+    {"++", TokenKind::PlusPlus},
+    {"--", TokenKind::MinusMinus},
+}};
+
+static_assert(OPERATORS.size() ==
+                      static_cast<std::size_t>(TokenKind::EndOfFile) - static_cast<std::size_t>(TokenKind::Plus),
+              "every symbol kind needs an entry in OPERATORS");
+
+// Keyword and operator spellings are resolved through perfect hash tables generated at compile time,
+// adding a spelling that collides with another one fails the build
+constexpr PerfectHashTable<TokenKind, KEYWORDS.size(), 4> KEYWORD_TABLE(KEYWORDS);
+constexpr PerfectHashTable<TokenKind, OPERATORS.size(), 7> OPERATOR_TABLE(OPERATORS);
+
+static_assert(KEYWORD_TABLE.isPerfect(), "no collision-free hash for KEYWORDS, grow the table");
+static_assert(OPERATOR_TABLE.isPerfect(), "no collision-free hash for OPERATORS, grow the table");
+
+// Returns the keyword kind for an identifier spelling, if it is one
+constexpr auto lookupKeyword(const std::string_view spelling) -> std::optional<TokenKind> {
+    return KEYWORD_TABLE.find(spelling);
+}
 
-private:
-    unsigned int m_line;
-    unsigned int m_column;
-};
+// Returns the kind of a one or two character operator or punctuation spelling, if it is one
+constexpr auto lookupOperator(const std::string_view spelling) -> std::optional<TokenKind> {
+    return OPERATOR_TABLE.find(spelling);
+}
+
+// Set of token kinds as a bit mask, membership is a shift and an and
+constexpr auto makeKindSet(const std::initializer_list<TokenKind> kinds) -> std::uint64_t {
+    std::uint64_t set = 0;
+    for (const TokenKind kind : kinds) {
+        set |= std::uint64_t{1} << static_cast<std::uint8_t>(kind);
+    }
+    return set;
+}
+
+constexpr std::uint64_t BINARY_OPERATORS = makeKindSet({
+    TokenKind::Plus,      TokenKind::Minus,        TokenKind::Star,     TokenKind::Slash,    TokenKind::EqualEqual,
+    TokenKind::BangEqual, TokenKind::Less,         TokenKind::Greater,  TokenKind::LessEqual, TokenKind::GreaterEqual,
+    TokenKind::AmpAmp,    TokenKind::PipePipe,     TokenKind::Percent,  TokenKind::LessLess,  TokenKind::GreaterGreater,
+    TokenKind::Amp,       TokenKind::Pipe,         TokenKind::Caret,
+});
+
+constexpr std::uint64_t UNARY_OPERATORS = makeKindSet({
+    TokenKind::Plus, TokenKind::Minus, TokenKind::Bang, TokenKind::Tilde, TokenKind::PlusPlus, TokenKind::MinusMinus,
+});
+
+constexpr auto isBinaryOperator(const TokenKind kind) -> bool {
+    return (BINARY_OPERATORS >> static_cast<std::uint8_t>(kind) & 1) != 0;
+}
+
+constexpr auto isUnaryOperator(const TokenKind kind) -> bool {
+    return (UNARY_OPERATORS >> static_cast<std::uint8_t>(kind) & 1) != 0;
+}
+
+// Spelling of keyword and operator kinds, a description of the other kinds, for diagnostics
+constexpr auto tokenKindToString(const TokenKind kind) -> std::string_view {
+    switch (kind) {
+        case TokenKind::Identifier:
+            return "identifier";
+        case TokenKind::Integer:
+            return "integer";
+        case TokenKind::Float:
+            return "float";
+        case TokenKind::String:
+            return "string";
+        case TokenKind::Char:
+            return "char";
+        case TokenKind::EndOfFile:
+            return "end of file";
+        default:
+            break;
+    }
+    for (const auto &[spelling, keyword] : KEYWORDS) {
+        if (keyword == kind) {
+            return spelling;
+        }
+    }
+    for (const auto &[spelling, symbol] : OPERATORS) {
+        if (symbol == kind) {
+            return spelling;
+        }
+    }
+    return "unknown token";
+}
 
-// Represents a single token
+// Maps a token kind onto the coarse token category
+constexpr auto getTokenType(const TokenKind kind) -> TokenType {
+    switch (kind) {
+        case TokenKind::Identifier:
+            return TokenType::Identifier;
+        case TokenKind::Integer:
+            return TokenType::Integer;
+        case TokenKind::Float:
+            return TokenType::Float;
+        case TokenKind::String:
+            return TokenType::String;
+        case TokenKind::Char:
+            return TokenType::Char;
+        case TokenKind::EndOfFile:
+            return TokenType::EndOfFile;
+        default:
+            return kind <= TokenKind::Func ? TokenType::Keyword : TokenType::Symbol;
+    }
+}
+
+constexpr auto isNumberKind(const TokenKind kind) -> bool {
+    return kind == TokenKind::Integer || kind == TokenKind::Float;
+}
+
+// Represents a single token, the value is a view into the SourceBuffer it was lexed from.
+// Only the byte offset is kept, SourceBuffer::getPosition turns it into a line and column when needed.
 class Token {
 public:
-    Token(std::string value, TokenType type, Position position);
+    Token() = default; // end of file token
+    Token(std::string_view value, TokenKind kind, std::uint32_t offset, SymbolId symbol = INVALID_SYMBOL);
+    Token(std::string_view value, TokenKind kind, std::uint32_t offset, NumberValue number);
 
+    [[nodiscard]] auto getKind() const -> TokenKind;
     [[nodiscard]] auto getType() const -> TokenType;
-    [[nodiscard]] auto getValue() const -> const std::string &;
-    [[nodiscard]] auto getPosition() const -> const Position &;
+    [[nodiscard]] auto getValue() const -> std::string_view;
+    [[nodiscard]] auto getOffset() const -> std::uint32_t;
+    [[nodiscard]] auto getSymbol() const -> SymbolId;    // interned id of identifiers, INVALID_SYMBOL otherwise
+    [[nodiscard]] auto getNumber() const -> NumberValue; // converted value of Integer and Float tokens, 0 otherwise
 
     void print() const;
 
 private:
-    TokenType   m_type;
-    std::string m_value;
-    Position    m_position;
+    TokenKind     m_kind = TokenKind::EndOfFile;
+    std::uint32_t m_offset = 0;
+    union { // by kind, the token stays four words
+        SymbolId    m_symbol = INVALID_SYMBOL;
+        NumberValue m_number;
+    };
+    std::string_view m_value;
+};
+
+// Compact struct-of-arrays token storage, 9 bytes per token:
+// the kind, the 32-bit source offset and a 32-bit payload holding the SymbolId of identifiers, the index of the
+// number entry of Integer and Float tokens or the length of any other token (the length of an identifier is the
+// length of its interned spelling). Number entries hold the converted value and the length, in token order.
+// That is one byte over the 8-byte target: the payload keeps the SymbolId with the token, so the parser never
+// interns a spelling again, and number tokens take a 16-byte entry on top.
+class TokenStore {
+public:
+    static constexpr std::size_t BYTES_PER_TOKEN = sizeof(TokenKind) + 2 * sizeof(std::uint32_t);
+
+    TokenStore(const SourceBuffer &source, const StringInterner &interner);
+
+    void push(const Token &token);
+    void reserve(std::size_t count);
+    void resize(std::size_t count, std::size_t numberCount);
+
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    // Bytes of the arrays in use, BYTES_PER_TOKEN per token plus the number entries
+    [[nodiscard]] auto getUsedBytes() const -> std::size_t;
+
+    [[nodiscard]] auto getKind(std::size_t index) const -> TokenKind;
+    [[nodiscard]] auto getOffset(std::size_t index) const -> std::uint32_t;
+    [[nodiscard]] auto getSymbol(std::size_t index) const -> SymbolId;
+    [[nodiscard]] auto getNumber(std::size_t index) const -> NumberValue;
+    [[nodiscard]] auto getValue(std::size_t index) const -> std::string_view;
+    [[nodiscard]] auto getPosition(std::size_t index) const -> Position;
+
+    // Length of the token value, identifiers take it from the interned spelling so the source is not touched
+    [[nodiscard]] auto getLength(std::size_t index) const -> std::uint32_t;
+
+    // Materializes the token at index, an EndOfFile token past the end
+    [[nodiscard]] auto operator[](std::size_t index) const -> Token;
+
+    [[nodiscard]] auto getSource() const -> const SourceBuffer &;
+    [[nodiscard]] auto getInterner() const -> const StringInterner &;
+
+    // Replaces the tokens [begin, end) with tokens, moves every later token by delta bytes and rebinds the store to
+    // source, the buffer all offsets refer to after the edit
+    void splice(std::size_t begin, std::size_t end, const std::vector<Token> &tokens, std::int64_t delta,
+                const SourceBuffer &source);
+
+    // Overwrites the tokens from index on with the tokens [first, last) of other, which must refer to the same source,
+    // and their number entries from numberIndex on. Identifier symbols are translated through symbols (indexed by the
+    // SymbolId in other), kept as is if it is empty.
+    void copy(std::size_t index, std::size_t numberIndex, const TokenStore &other, std::size_t first,
+              std::size_t last, std::span<const SymbolId> symbols);
+
+    // Number of Integer and Float tokens in [first, last), the number entries copy needs room for
+    [[nodiscard]] auto countNumbers(std::size_t first, std::size_t last) const -> std::size_t;
+
+private:
+    struct NumberEntry {
+        NumberValue   value;
+        std::uint32_t length;
+    };
+
+    // Index of the number entry of the first number token from index on, the entry count if there is none
+    [[nodiscard]] auto numberIndex(std::size_t index) const -> std::size_t;
+
+    const SourceBuffer   *m_source;
+    const StringInterner *m_interner;
+
+    std::vector<TokenKind>     m_kinds;
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<std::uint32_t> m_payloads;
+    std::vector<NumberEntry>   m_numbers;
+};
+
+// A single edit of a source: the length bytes at offset were replaced by replacement
+struct SourceEdit {
+    std::uint32_t    offset = 0;
+    std::uint32_t    length = 0;
+    std::string_view replacement;
+};
+
+// Result of a relex: the tokens [begin, oldEnd) of the previous stream were replaced by the tokens [begin, newEnd),
+// every token from newEnd on is the same token as before, only moved by the size difference of the edit
+struct TokenRange {
+    std::size_t begin = 0;
+    std::size_t oldEnd = 0;
+    std::size_t newEnd = 0;
+};
+
+// Thrown by the Tokenizer on malformed input, lets callers tell lexical errors from parse errors when streaming
+class TokenizerError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Pull-based source of tokens with a small bounded lookahead, the Parser consumes tokens through this interface
+class TokenStream {
+public:
+    virtual ~TokenStream() = default;
+
+    // Returns the token k positions ahead without consuming it, an EndOfFile token once the source is exhausted
+    virtual auto peek(std::size_t k = 0) -> const Token & = 0;
+
+    // Consumes and returns the current token
+    virtual auto next() -> Token = 0;
+
+    // Source the token offsets refer to, used to turn them into positions for diagnostics
+    [[nodiscard]] virtual auto getSource() const -> const SourceBuffer & = 0;
+
+    // Interner the identifier symbols of the tokens belong to
+    [[nodiscard]] virtual auto getInterner() const -> const StringInterner & = 0;
+};
+
+// Token stream over a TokenStore, lets the Parser consume an already materialized token sequence
+class TokenStoreStream final : public TokenStream {
+public:
+    explicit TokenStoreStream(const TokenStore &tokens);
+
+    // Stream over the tokens [begin, end) of the store, the EndOfFile token is placed at the offset of token end
+    TokenStoreStream(const TokenStore &tokens, std::size_t begin, std::size_t end);
+
+    auto peek(std::size_t k = 0) -> const Token & override;
+    auto next() -> Token override;
+
+    [[nodiscard]] auto getSource() const -> const SourceBuffer & override;
+    [[nodiscard]] auto getInterner() const -> const StringInterner & override;
+
+private:
+    static constexpr std::size_t WINDOW = 4;
+
+    const TokenStore *m_tokens;
+    std::size_t       m_current_index = 0;
+    std::size_t       m_end;
+
+    // Ring buffer of the materialized tokens from the current index on
+    std::array<Token, WINDOW> m_window;
+    std::size_t               m_window_start = 0;
+    std::size_t               m_window_count = 0;
 };
 
 // Tokenizer class for processing source files into tokens
-class Tokenizer {
+// Driven by a 256-entry character class table, the source buffer must outlive every token it produces.
+// Tokens are lexed on demand, so memory is bounded by the lookahead rather than by the file size.
+// Identifiers are interned as they are lexed, the interner must outlive the tokens as well.
+class Tokenizer final : public TokenStream {
 public:
-    explicit Tokenizer(const std::string &filepath);
+    static constexpr std::size_t LOOKAHEAD = 4;
+
+    // Without a diagnostics sink the first lexical error is thrown as a TokenizerError. With one, errors are
+    // recorded, the offending text is skipped and lexing continues, so a single pass finds every lexical error.
+    Tokenizer(const SourceBuffer &source, StringInterner &interner, Diagnostics *diagnostics = nullptr);
+
+    auto peek(std::size_t k = 0) -> const Token & override;
+    auto next() -> Token override;
 
-    auto tokenize() -> std::vector<Token>;
+    [[nodiscard]] auto getSource() const -> const SourceBuffer & override;
+    [[nodiscard]] auto getInterner() const -> const StringInterner & override;
 
-    [[nodiscard]] auto getTokens() const -> const std::vector<Token> &;
+    // Lexes all remaining tokens into a TokenStore (without the EndOfFile token)
+    auto tokenize() -> TokenStore;
+
+    // Updates tokens, lexed from the source before edit, to source (the text after edit) without lexing the whole
+    // file again. Lexing restarts at the last token boundary the edit cannot affect and stops as soon as a new token
+    // lines up with an old one behind the edit. The store is left untouched if the edited range fails to lex.
+    static auto relex(TokenStore &tokens, const SourceBuffer &source, StringInterner &interner, const SourceEdit &edit)
+            -> TokenRange;
+
+    // Lexes all remaining tokens like tokenize, on up to threads worker threads (0 = one per hardware thread).
+    // The source is split into chunks after newlines that are lexed speculatively, as if no string literal spans the
+    // split, and stitched back together with the serial lexer wherever that guess was wrong. Identifiers are
+    // re-interned in source order, so the result matches tokenize exactly, symbol ids included.
+    // Error recovery depends on the exact lexer state, so a tokenizer with a diagnostics sink lexes serially.
+    auto tokenizeParallel(unsigned int threads = 0) -> TokenStore;
 
 private:
-    std::filesystem::path m_filepath;
-    std::string           m_source;
-    std::vector<Token>    m_tokens;
+    const SourceBuffer *m_sourceBuffer;
+    std::string_view    m_source;
+    StringInterner     *m_interner;
+    Diagnostics        *m_diagnostics;
+
+    // Ring buffer of tokens that have been lexed but not consumed yet
+    std::array<Token, LOOKAHEAD> m_lookahead;
+    std::size_t                  m_lookahead_start = 0;
+    std::size_t                  m_lookahead_count = 0;
 
     long long unsigned int m_max_index = 0;
     long long unsigned int m_current_index = 0;
 
-    unsigned int m_line = 1;
-    unsigned int m_column = 1;
+    // Sources smaller than this are not worth splitting
+    static constexpr std::size_t MIN_CHUNK_SIZE = 1 << 20;
+
+    auto lexToken() -> Token;
+    auto lexChunk(std::size_t end, TokenStore &tokens, std::size_t &symbolCount) -> std::size_t;
 
     void handleWhiteSpace();
-    void handleKeyword();
-    void handleSymbol();
-    void handleStringOrChar();
-    void handleNumber();
-    void handleIdentifierOrKeyword();
+    void handleComment();
+    auto handleSymbol() -> Token;
+    auto handleStringOrChar() -> std::optional<Token>;
+    auto handleNumber() -> std::optional<Token>;
+    auto handleIdentifierOrKeyword() -> Token;
 
     void advance();
-    void addToken(TokenType type, const std::string &value);
-    void throwError(const std::string &message) const;
-
-    [[nodiscard]] auto readSource() const -> std::string;
+    void advanceTo(const char *position);
+    auto makeToken(TokenKind kind, std::size_t start) const -> Token;
+    auto makeToken(TokenKind kind, std::size_t start, std::size_t length) const -> Token;
+    void reportError(std::string_view message, std::size_t start, std::size_t end);
+    [[noreturn]] void throwError(const std::string &message) const;
 };
 
 inline auto tokenTypeToString(const TokenType type) -> std::string {
@@ -112,23 +511,65 @@ inline auto tokenTypeToString(const TokenType type) -> std::string {
             return "Keyword";
         case TokenType::Symbol:
             return "Symbol";
+        case TokenType::EndOfFile:
+            return "EndOfFile";
         default:
             return "Unknown";
     }
 }
 
-inline auto Tokenizer::getTokens() const -> const std::vector<Token> & { return m_tokens; }
+inline auto Token::getKind() const -> TokenKind { return m_kind; }
 
-inline auto Token::getType() const -> TokenType { return m_type; }
+inline auto Token::getType() const -> TokenType { return getTokenType(m_kind); }
 
-inline auto Token::getValue() const -> const std::string & { return m_value; }
+inline auto Token::getValue() const -> std::string_view { return m_value; }
 
 inline void Token::print() const {
-    std::cout << "Token: " << m_value << "\t(" << tokenTypeToString(m_type) << ")" << '\n';
+    std::cout << "Token: " << m_value << "\t(" << tokenTypeToString(getType()) << ")" << '\n';
 }
 
-inline auto Token::getPosition() const -> const Position & { return m_position; }
+inline auto Token::getOffset() const -> std::uint32_t { return m_offset; }
+
+inline auto Token::getSymbol() const -> SymbolId {
+    return m_kind == TokenKind::Identifier ? m_symbol : INVALID_SYMBOL;
+}
+
+inline auto Token::getNumber() const -> NumberValue { return isNumberKind(m_kind) ? m_number : NumberValue{}; }
+
+inline auto TokenStore::size() const -> std::size_t { return m_kinds.size(); }
+
+inline auto TokenStore::getUsedBytes() const -> std::size_t {
+    return size() * BYTES_PER_TOKEN + m_numbers.size() * sizeof(NumberEntry);
+}
+
+inline auto TokenStore::getKind(const std::size_t index) const -> TokenKind {
+    return index < m_kinds.size() ? m_kinds[index] : TokenKind::EndOfFile;
+}
+
+inline auto TokenStore::getOffset(const std::size_t index) const -> std::uint32_t {
+    return index < m_offsets.size() ? m_offsets[index] : static_cast<std::uint32_t>(m_source->size());
+}
+
+inline auto TokenStore::getSymbol(const std::size_t index) const -> SymbolId {
+    return getKind(index) == TokenKind::Identifier ? m_payloads[index] : INVALID_SYMBOL;
+}
+
+inline auto TokenStore::getNumber(const std::size_t index) const -> NumberValue {
+    return isNumberKind(getKind(index)) ? m_numbers[m_payloads[index]].value : NumberValue{};
+}
+
+inline auto TokenStore::getPosition(const std::size_t index) const -> Position {
+    return m_source->getPosition(getOffset(index));
+}
+
+inline auto TokenStore::getSource() const -> const SourceBuffer & { return *m_source; }
+
+inline auto TokenStore::getInterner() const -> const StringInterner & { return *m_interner; }
+
+inline auto TokenStoreStream::getSource() const -> const SourceBuffer & { return m_tokens->getSource(); }
+
+inline auto TokenStoreStream::getInterner() const -> const StringInterner & { return m_tokens->getInterner(); }
 
-inline auto Position::getLine() const -> unsigned int { return m_line; }
+inline auto Tokenizer::getSource() const -> const SourceBuffer & { return *m_sourceBuffer; }
 
-inline auto Position::getColumn() const -> unsigned int { return m_column; }
+inline auto Tokenizer::getInterner() const -> const StringInterner & { return *m_interner; }
@@ -14,6 +14,7 @@ class WhileLoop;
 class ReturnStatement;
 class ExpressionStatement;
 class Assignment;
+class ErrorNode;
 
 class Visitor {
 public:
@@ -33,4 +34,5 @@ public:
     virtual void visit(ReturnStatement &node) = 0;
     virtual void visit(ExpressionStatement &node) = 0;
     virtual void visit(Assignment &node) = 0;
+    virtual void visit(ErrorNode &node) = 0;
 };
@@ -1,82 +1,99 @@
 #include "../include/AbstractSyntaxTree.h"
 
-void Block::print(const std::string indent) const {
-    std::cout << indent << "Block" << '\n';
-    for (const auto &statement : statements) {
-        statement->print(indent + "  ");
+#include "../include/AstWalker.h"
+
+void AbstractNode::print(const std::string &indent) const {
+    // the walker hands out mutable nodes, printing doesn't modify them
+    AstWalker walker;
+    walker.walk(
+            const_cast<AbstractNode &>(*this),
+            [&](const AbstractNode &node, const AbstractNode *, const std::size_t depth) {
+                // the body of a program is printed at the indentation of the program
+                const std::size_t level = getKind() == NodeKind::Program && depth > 0 ? depth - 1 : depth;
+                node.printNode(indent + std::string(2 * level, ' '));
+                return true;
+            },
+            [](const AbstractNode &, const AbstractNode *) {});
+}
+
+void Block::printNode(const std::string &indent) const { std::cout << indent << "Block" << '\n'; }
+
+auto Program::getStatistics() const -> AstStatistics {
+    AstStatistics statistics;
+    for (const auto &arena : arenas) {
+        statistics += arena->getStatistics();
     }
+    return statistics;
 }
 
-void Program::print(const std::string indent) const {
-    std::cout << indent << "Program: " << name << '\n';
-    body->print(indent);
+auto Program::needsCompaction() const -> bool { return deadBytes > getStatistics().getUsedBytes() - deadBytes; }
+
+auto getSubtreeStatistics(const AbstractNode &root) -> AstStatistics {
+    AstStatistics statistics;
+    AstWalker     walker;
+    walker.walk(
+            const_cast<AbstractNode &>(root),
+            [&](AbstractNode &node, const AbstractNode *, std::size_t) {
+                dispatchNode(node, [&]<typename Node>(const Node &typed) {
+                    statistics.nodeCounts[static_cast<std::size_t>(Node::KIND)]++;
+                    statistics.nodeBytes += sizeof(Node);
+                    if constexpr (std::is_same_v<Node, Block>) {
+                        statistics.listBytes += typed.statements.size_bytes();
+                    } else if constexpr (std::is_same_v<Node, FunctionDeclaration>) {
+                        statistics.listBytes += typed.parameters.size_bytes();
+                    } else if constexpr (std::is_same_v<Node, FunctionCall>) {
+                        statistics.listBytes += typed.arguments.size_bytes();
+                    } else if constexpr (std::is_same_v<Node, Literal>) {
+                        statistics.stringBytes += typed.value.size();
+                    }
+                });
+                return true;
+            },
+            [](const AbstractNode &, const AbstractNode *) {});
+    return statistics;
 }
 
-void FunctionDeclaration::print(const std::string indent) const {
+void Program::printNode(const std::string &indent) const { std::cout << indent << "Program: " << name << '\n'; }
+
+void FunctionDeclaration::printNode(const std::string &indent) const {
     std::cout << indent << "Function Declaration: " << name << '\n';
     for (const auto &parameter : parameters) {
         std::cout << indent + "  " << "Parameter: " << parameter.type << " " << parameter.name << '\n';
     }
-    body->print(indent + "  ");
 }
 
-void FunctionCall::print(const std::string indent) const {
+void FunctionCall::printNode(const std::string &indent) const {
     std::cout << indent << "Function Call: " << name << '\n';
-    for (const auto &argument : arguments) {
-        argument->print(indent + "  ");
-    }
 }
 
-void VariableDeclaration::print(const std::string indent) const {
+void VariableDeclaration::printNode(const std::string &indent) const {
     std::cout << indent << "Variable Declaration: " << type << " " << name << '\n';
-    if (this->initializer) {
-        this->initializer->print(indent + "  ");
-    }
 }
 
-void Assignment::print(const std::string indent) const {
-    std::cout << indent << "Assignment: " << name << '\n';
-    value->print(indent + "  ");
-}
+void Assignment::printNode(const std::string &indent) const { std::cout << indent << "Assignment: " << name << '\n'; }
 
-void ReturnStatement::print(const std::string indent) const {
+void ReturnStatement::printNode(const std::string &indent) const {
     std::cout << indent << "Return Statement" << '\n';
-    if (expression) {
-        expression->print(indent + "  ");
-    }
 }
 
-void ExpressionStatement::print(const std::string indent) const {
+void ExpressionStatement::printNode(const std::string &indent) const {
     std::cout << indent << "Expression Statement" << '\n';
-    expression->print(indent + "  ");
 }
 
-void WhileLoop::print(const std::string indent) const {
-    std::cout << indent << "While Loop" << '\n';
-    condition->print(indent + "  ");
-    body->print(indent + "  ");
-}
+void WhileLoop::printNode(const std::string &indent) const { std::cout << indent << "While Loop" << '\n'; }
 
-void IfStatement::print(const std::string indent) const {
-    std::cout << indent << "If Statement" << '\n';
-    condition->print(indent + "  ");
-    thenBranch->print(indent + "  ");
-    if (elseBranch) {
-        elseBranch->print(indent + "  ");
-    }
-}
+void IfStatement::printNode(const std::string &indent) const { std::cout << indent << "If Statement" << '\n'; }
 
-void Literal::print(const std::string indent) const { std::cout << indent << "Literal: " << value << '\n'; }
+void Literal::printNode(const std::string &indent) const { std::cout << indent << "Literal: " << value << '\n'; }
 
-void BinaryOperation::print(const std::string indent) const {
-    std::cout << indent << "Binary Operation: " << operatorSymbol << '\n';
-    left->print(indent + "  ");
-    right->print(indent + "  ");
+void BinaryOperation::printNode(const std::string &indent) const {
+    std::cout << indent << "Binary Operation: " << operatorKindToString(operatorKind) << '\n';
 }
 
-void UnaryOperation::print(const std::string indent) const {
-    std::cout << indent << "Unary Operation: " << operatorSymbol << '\n';
-    operand->print(indent + "  ");
+void UnaryOperation::printNode(const std::string &indent) const {
+    std::cout << indent << "Unary Operation: " << operatorKindToString(operatorKind) << '\n';
 }
 
-void Reference::print(const std::string indent) const { std::cout << indent << "Reference: " << name << '\n'; }
+void Reference::printNode(const std::string &indent) const { std::cout << indent << "Reference: " << name << '\n'; }
+
+void ErrorNode::printNode(const std::string &indent) const { std::cout << indent << "Error: " << message << '\n'; }
@@ -0,0 +1,11 @@
+#include "../include/AstArena.h"
+
+void AstStatistics::print(std::ostream &out) const {
+    out << "AST: " << getNodeCount() << " nodes, " << getUsedBytes() << " bytes used (" << nodeBytes << " nodes, "
+        << listBytes << " lists, " << stringBytes << " strings), " << reservedBytes << " bytes reserved\n";
+    for (std::size_t kind = 0; kind < NODE_KIND_COUNT; ++kind) {
+        if (nodeCounts[kind] != 0) {
+            out << "  " << nodeKindToString(static_cast<NodeKind>(kind)) << ": " << nodeCounts[kind] << '\n';
+        }
+    }
+}
@@ -2,14 +2,20 @@
 
 #include "../include/CodeGenerator.h"
 
+#include <cmath>
+#include <limits>
 #include <set>
 
 using namespace llvm;
 
 CodeGenerator::CodeGenerator() : builder(context) {}
 
-void CodeGenerator::generateCode(const std::unique_ptr<Program> &program) {
-    program->accept(*this); // Start the code generation process
+void CodeGenerator::generateCode(const std::unique_ptr<Program> &program, const Resolution &resolution) {
+    variableValues.assign(resolution.variableCount, nullptr);
+    variableTypes.assign(resolution.variableCount, nullptr);
+    functions.assign(resolution.functionCount, nullptr);
+
+    generate(*program); // Start the code generation process
 
     // error handling + writing to file
     std::error_code errorCode;
@@ -25,15 +31,80 @@ void CodeGenerator::generateCode(const std::unique_ptr<Program> &program) {
     module->print(outs(), nullptr);
 }
 
+void CodeGenerator::generate(AbstractNode &node) {
+    const std::size_t base = m_tasks.size();
+    generateStatement(node);
+    while (m_tasks.size() > base) {
+        const Task task = m_tasks.back();
+        m_tasks.pop_back();
+        switch (task.kind) {
+            case Task::Kind::Generate:
+                generateStatement(*task.node);
+                break;
+            case Task::Kind::Branch:
+                builder.CreateBr(task.block);
+                break;
+            case Task::Kind::InsertAt:
+                builder.SetInsertPoint(task.block);
+                break;
+        }
+    }
+}
+
+void CodeGenerator::generateStatement(AbstractNode &statement) {
+    // calls are the only expressions that stand as statements
+    if (statement.getKind() == NodeKind::FunctionCall) {
+        generateExpression(statement);
+        return;
+    }
+    statement.accept(*this);
+}
+
+void CodeGenerator::generateExpression(AbstractNode &expression) {
+    m_walker.walk(
+            expression, [](AbstractNode &, AbstractNode *, std::size_t) { return true; },
+            [&](AbstractNode &node, const AbstractNode *operation) {
+                node.accept(*this);
+                if (operation != nullptr) {
+                    m_operands.push_back(loadOperand(node, *operation));
+                }
+            });
+}
+
+auto CodeGenerator::loadOperand(AbstractNode &operand, const AbstractNode &operation) -> Value * {
+    Value *value = operand.getValue();
+    if (!value->getType()->isPointerTy()) {
+        return value;
+    }
+    switch (operation.getKind()) {
+        case NodeKind::BinaryOperation:
+            return builder.CreateLoad(operand.getType(), value,
+                                      static_cast<const BinaryOperation &>(operation).left == &operand
+                                              ? "loadLeftTmp"
+                                              : "loadRightTmp");
+        case NodeKind::UnaryOperation:
+            return builder.CreateLoad(operand.getType(), value, "loadOperandTmp");
+        default:
+            return builder.CreateLoad(operand.getType(), value, "loadArgTmp");
+    }
+}
+
+auto CodeGenerator::popOperands(const std::size_t count) -> std::vector<Value *> {
+    std::vector<Value *> values(m_operands.end() - static_cast<std::ptrdiff_t>(count), m_operands.end());
+    m_operands.resize(m_operands.size() - count);
+    return values;
+}
+
 void CodeGenerator::visit(Program &node) {
     module = std::make_unique<Module>(node.name, context);
 
-    node.body->accept(*this);
+    m_tasks.push_back({Task::Kind::Generate, node.body});
 }
 
 void CodeGenerator::visit(Block &node) {
-    for (const auto &statement : node.statements) {
-        statement->accept(*this);
+    // the first statement is generated first
+    for (auto statement = node.statements.rbegin(); statement != node.statements.rend(); ++statement) {
+        m_tasks.push_back({Task::Kind::Generate, *statement});
     }
 }
 
@@ -47,6 +118,7 @@ void CodeGenerator::visit(FunctionDeclaration &node) {
 
     FunctionType *functionType = FunctionType::get(returnType, paramTypes, false);
     Function     *function = Function::Create(functionType, Function::ExternalLinkage, node.name, module.get());
+    bindFunction(node.slot, function);
 
     // Set the names for the function parameters
     unsigned idx = 0;
@@ -59,16 +131,16 @@ void CodeGenerator::visit(FunctionDeclaration &node) {
     builder.SetInsertPoint(basicBlock);
 
     // Allocate space for function parameters and store their values
+    idx = 0;
     for (auto &arg : function->args()) {
         AllocaInst *alloca = builder.CreateAlloca(arg.getType(), nullptr, arg.getName() + ".addr");
         builder.CreateStore(&arg, alloca);
 
-        refNameToValue[arg.getName().str()] = alloca;
-        refNameToType[arg.getName().str()] = arg.getType();
+        bindVariable(node.parameters[idx++].slot, alloca, arg.getType());
     }
 
     if (node.body) {
-        node.body->accept(*this);
+        m_tasks.push_back({Task::Kind::Generate, node.body});
     }
 }
 
@@ -83,11 +155,10 @@ void CodeGenerator::visit(VariableDeclaration &node) {
     IRBuilder   tmpBuilder(&function->getEntryBlock(), function->getEntryBlock().begin());
     AllocaInst *alloca = tmpBuilder.CreateAlloca(varType, nullptr, node.name);
 
-    refNameToValue[node.name] = alloca;
-    refNameToType[node.name] = varType;
+    bindVariable(node.slot, alloca, varType);
 
     if (node.initializer) {
-        node.initializer->accept(*this);
+        generateExpression(*node.initializer);
         Value *value = node.initializer->getValue();
 
         if (value->getType()->isPointerTy()) {
@@ -104,30 +175,16 @@ void CodeGenerator::visit(VariableDeclaration &node) {
     }
 }
 
-static const std::set<std::string> BUILT_IN_FUNCTIONS = {"printf"};
+static const std::set<std::string, std::less<>> BUILT_IN_FUNCTIONS = {"printf"};
 
 void CodeGenerator::visit(FunctionCall &node) {
+    // the arguments have been generated by generateExpression
+    std::vector<Value *> args = popOperands(node.arguments.size());
+
     if (BUILT_IN_FUNCTIONS.contains(node.name)) {
         // Handle built-in functions
         if (node.name == "printf") {
             // Handle printf
-            std::vector<Value *> args;
-            for (const auto &arg : node.arguments) {
-                arg->accept(*this);
-                Value *argValue = arg->getValue();
-
-                if (argValue->getType()->isPointerTy()) {
-                    argValue = builder.CreateLoad(arg->getType(), argValue, "loadArgTmp");
-                }
-
-                if (argValue != nullptr) {
-                    args.push_back(argValue);
-                } else {
-                    errs() << "Failed to generate argument for printf\n";
-                    return;
-                }
-            }
-
             FunctionCallee printfFunc = module->getOrInsertFunction(
                     "printf", FunctionType::get(IntegerType::getInt32Ty(context),
                                                 PointerType::get(Type::getInt8Ty(context), 0), true));
@@ -139,28 +196,12 @@ void CodeGenerator::visit(FunctionCall &node) {
         return;
     }
 
-    Function *function = module->getFunction(node.name);
+    Function *function = lookupFunction(node.slot);
     if (function == nullptr) {
         errs() << "Function not found: " << node.name << "\n";
         return;
     }
 
-    std::vector<Value *> args;
-    for (const auto &arg : node.arguments) {
-        arg->accept(*this);
-        Value *argValue = arg->getValue();
-
-        if (argValue->getType()->isPointerTy()) {
-            argValue = builder.CreateLoad(arg->getType(), argValue, "loadArgTmp");
-        }
-
-        if (argValue != nullptr) {
-            args.push_back(argValue);
-        } else {
-            errs() << "Failed to generate argument for function call: " << node.name << "\n";
-            return;
-        }
-    }
     if (function->getReturnType()->isVoidTy()) {
         builder.CreateCall(function, args);
     } else {
@@ -173,16 +214,16 @@ void CodeGenerator::visit(FunctionCall &node) {
 
 void CodeGenerator::visit(Literal &node) {
     // Generate the value for the literal, no pointer
-    Value *value = getValueFromLiteral(node.value, node.type);
+    Value *value = getValueFromLiteral(node);
 
     node.setValue(value);
-    node.setType(typeToLLVMType(node.type));
+    node.setType(value->getType());
 }
 
 void CodeGenerator::visit(Reference &node) {
     // Generate code for the variable reference
-    Value *value = refNameToValue[node.name];
-    Type  *type = refNameToType[node.name];
+    Value *value = lookupValue(node.slot);
+    Type  *type = lookupType(node.slot);
     if (value == nullptr || type == nullptr) {
         errs() << "Unknown variable name: " << node.name << "\n";
     }
@@ -191,26 +232,18 @@ void CodeGenerator::visit(Reference &node) {
 }
 
 void CodeGenerator::visit(BinaryOperation &node) {
-    // Generate code for the left and right operands
-    node.left->accept(*this);
-    Value *leftValue = node.left->getValue();
-
-    if (leftValue->getType()->isPointerTy()) {
-        leftValue = builder.CreateLoad(node.left->getType(), leftValue, "loadLeftTmp");
-    }
-
-    node.right->accept(*this);
-    Value *rightValue = node.right->getValue();
+    // the operands have been generated by generateExpression
+    Value *rightValue = m_operands.back();
+    m_operands.pop_back();
+    Value *leftValue = m_operands.back();
+    m_operands.pop_back();
 
-    if (rightValue->getType()->isPointerTy()) {
-        rightValue = builder.CreateLoad(node.right->getType(), rightValue, "loadRightTmp");
-    }
-
-    Value *result = getBinaryLLVM(node.operatorSymbol, leftValue, rightValue);
+    Value *result = getBinaryLLVM(node.operatorKind, leftValue, rightValue);
 
     if (result == nullptr) {
-        errs() << "Unknown binary operator: " << node.operatorSymbol << "\n";
-        throw std::runtime_error("Unknown binary operator: " + node.operatorSymbol);
+        const std::string_view op = operatorKindToString(node.operatorKind);
+        errs() << "Unknown binary operator: " << op << "\n";
+        throw std::runtime_error("Unknown binary operator: " + std::string(op));
     }
 
     node.setValue(result);           // Store the generated value in the node
@@ -218,18 +251,16 @@ void CodeGenerator::visit(BinaryOperation &node) {
 }
 
 void CodeGenerator::visit(UnaryOperation &node) {
-    node.operand->accept(*this);
-    Value *operandValue = node.operand->getValue();
-
-    if (operandValue->getType()->isPointerTy()) {
-        operandValue = builder.CreateLoad(node.operand->getType(), operandValue, "loadOperandTmp");
-    }
+    // the operand has been generated by generateExpression
+    Value *operandValue = m_operands.back();
+    m_operands.pop_back();
 
-    Value *result = getUnaryLLVM(node.operatorSymbol, operandValue);
+    Value *result = getUnaryLLVM(node.operatorKind, operandValue);
 
     if (result == nullptr) {
-        errs() << "Unknown unary operator: " << node.operatorSymbol << "\n";
-        throw std::runtime_error("Unknown unary operator: " + node.operatorSymbol);
+        const std::string_view op = operatorKindToString(node.operatorKind);
+        errs() << "Unknown unary operator: " << op << "\n";
+        throw std::runtime_error("Unknown unary operator: " + std::string(op));
     }
 
     node.setValue(result);           // Store the generated value in the node
@@ -242,22 +273,21 @@ void CodeGenerator::visit(IfStatement &node) {
     BasicBlock *elseBlock = BasicBlock::Create(context, "else", function);
     BasicBlock *mergeBlock = BasicBlock::Create(context, "ifCont", function);
 
-    node.condition->accept(*this);
+    generateExpression(*node.condition);
     Value *condValue = node.condition->getValue();
 
     builder.CreateCondBr(condValue, thenBlock, elseBlock);
 
     builder.SetInsertPoint(thenBlock);
-        node.thenBranch->accept(*this);
-    builder.CreateBr(mergeBlock);
-
-    builder.SetInsertPoint(elseBlock);
-        if (node.elseBranch) {
-            node.elseBranch->accept(*this);
-        }
-    builder.CreateBr(mergeBlock);
-
-    builder.SetInsertPoint(mergeBlock);
+    // then branch, br merge, else: else branch, br merge, merge: pushed in reverse
+    m_tasks.push_back({Task::Kind::InsertAt, nullptr, mergeBlock});
+    m_tasks.push_back({Task::Kind::Branch, nullptr, mergeBlock});
+    if (node.elseBranch) {
+        m_tasks.push_back({Task::Kind::Generate, node.elseBranch});
+    }
+    m_tasks.push_back({Task::Kind::InsertAt, nullptr, elseBlock});
+    m_tasks.push_back({Task::Kind::Branch, nullptr, mergeBlock});
+    m_tasks.push_back({Task::Kind::Generate, node.thenBranch});
 }
 
 void CodeGenerator::visit(WhileLoop &node) {
@@ -269,21 +299,21 @@ void CodeGenerator::visit(WhileLoop &node) {
     builder.CreateBr(headerBlock);
 
     builder.SetInsertPoint(headerBlock);
-        node.condition->accept(*this);
+        generateExpression(*node.condition);
         Value *condValue = node.condition->getValue();
     builder.CreateCondBr(condValue, bodyBlock, exitBlock);
 
     builder.SetInsertPoint(bodyBlock);
-        node.body->accept(*this);
-    builder.CreateBr(headerBlock);
-
-    builder.SetInsertPoint(exitBlock);
+    // body, br header, exit: pushed in reverse
+    m_tasks.push_back({Task::Kind::InsertAt, nullptr, exitBlock});
+    m_tasks.push_back({Task::Kind::Branch, nullptr, headerBlock});
+    m_tasks.push_back({Task::Kind::Generate, node.body});
 }
 
 void CodeGenerator::visit(ReturnStatement &node) {
     // Generate code for the return expression
     if (node.expression != nullptr) {
-        node.expression->accept(*this);
+        generateExpression(*node.expression);
         Value *returnValuePointer = node.expression->getValue();
 
         // Load the return value if it is a pointer (literals are stored directly)
@@ -300,12 +330,12 @@ void CodeGenerator::visit(ReturnStatement &node) {
 
 void CodeGenerator::visit(ExpressionStatement &node) {
     // Generate code for the expression
-    node.expression->accept(*this);
+    generateExpression(*node.expression);
 }
 
 void CodeGenerator::visit(Assignment &node) {
     // Generate code for the value to be assigned
-    node.value->accept(*this);
+    generateExpression(*node.value);
     Value *valuePointer = node.value->getValue();
 
 
@@ -315,8 +345,8 @@ void CodeGenerator::visit(Assignment &node) {
         value = builder.CreateLoad(node.value->getType(), valuePointer, "loadTmp");
     }
 
-    Value *variable = refNameToValue[node.name];
-    Type  *variableType = refNameToType[node.name];
+    Value *variable = lookupValue(node.slot);
+    Type  *variableType = lookupType(node.slot);
 
     if (!variable || !variableType) {
         errs() << "Unknown variable name or type: " << node.name << "\n";
@@ -332,9 +362,14 @@ void CodeGenerator::visit(Assignment &node) {
     builder.CreateStore(value, variable);
 }
 
-auto CodeGenerator::typeToLLVMType(const std::string &type) -> Type * {
+void CodeGenerator::visit(ErrorNode &node) {
+    // the parser only leaves error nodes in a tree it reported errors for
+    throw std::runtime_error("Cannot generate code for a syntax error: " + std::string(node.message));
+}
+
+auto CodeGenerator::typeToLLVMType(const std::string_view type) -> Type * {
     // to lowercase
-    std::string type2 = type;
+    std::string type2(type);
     std::ranges::transform(type2, type2.begin(), ::tolower);
 
     if (type2 == "char" || type2 == "byte") {
@@ -358,103 +393,97 @@ auto CodeGenerator::typeToLLVMType(const std::string &type) -> Type * {
     return nullptr;
 }
 
-auto CodeGenerator::getValueFromLiteral(const std::string &value, const std::string &type) -> Value * {
-    Type *llvmType = typeToLLVMType(type);
-    if (!llvmType) {
-        errs() << "Unknown type: " << type << "\n";
-        return nullptr;
-    }
-
-    if (llvmType->isIntegerTy()) {
-        if (type == "char") {
-            return ConstantInt::get(llvmType, static_cast<uint32_t>(value[0]));
-        }
-        return ConstantInt::get(llvmType, std::stoi(value));
-    }
-    if (llvmType->isFloatTy()) {
-        return ConstantFP::get(context, APFloat(std::stof(value)));
-    }
-    if (llvmType->isDoubleTy()) {
-        return ConstantFP::get(context, APFloat(std::stod(value)));
-    }
-    if (llvmType->isPointerTy()) {
-        if (type == "string") {
-            return builder.CreateGlobalStringPtr(value);
-        }
-        return ConstantPointerNull::get(static_cast<PointerType *>(llvmType));
-    }
-    if (llvmType->isVoidTy()) {
-        return nullptr;
+auto CodeGenerator::getValueFromLiteral(const Literal &literal) -> Value * {
+    // numbers were converted by the lexer, only the range of the target type is left to check
+    switch (literal.literalKind) {
+        case LiteralKind::Integer:
+            if (literal.number.integer < std::numeric_limits<std::int32_t>::min() ||
+                literal.number.integer > std::numeric_limits<std::int32_t>::max()) {
+                throw std::runtime_error("Integer literal out of range of int: " + std::string(literal.value));
+            }
+            return ConstantInt::get(Type::getInt32Ty(context), literal.number.integer, true);
+        case LiteralKind::Float:
+            if (std::abs(literal.number.floating) > std::numeric_limits<float>::max()) {
+                throw std::runtime_error("Float literal out of range of float: " + std::string(literal.value));
+            }
+            return ConstantFP::get(context, APFloat(static_cast<float>(literal.number.floating)));
+        case LiteralKind::Char:
+            return ConstantInt::get(Type::getInt8Ty(context), static_cast<unsigned char>(literal.value[0]));
+        case LiteralKind::String:
+            return builder.CreateGlobalStringPtr(literal.value);
     }
-
     return nullptr;
 }
 
-auto CodeGenerator::getBinaryLLVM(const std::string &op, Value *leftValue, Value *rightValue) -> Value * {
+auto CodeGenerator::getBinaryLLVM(const OperatorKind op, Value *leftValue, Value *rightValue) -> Value * {
     const bool isFloat = leftValue->getType()->isFloatingPointTy() || rightValue->getType()->isFloatingPointTy();
 
-    if (op == "+")
-        return isFloat ? builder.CreateFAdd(leftValue, rightValue, "addTmp")
-                       : builder.CreateAdd(leftValue, rightValue, "addTmp");
-    if (op == "-")
-        return isFloat ? builder.CreateFSub(leftValue, rightValue, "subTmp")
-                       : builder.CreateSub(leftValue, rightValue, "subTmp");
-    if (op == "*")
-        return isFloat ? builder.CreateFMul(leftValue, rightValue, "mulTmp")
-                       : builder.CreateMul(leftValue, rightValue, "mulTmp");
-    if (op == "/")
-        return isFloat ? builder.CreateFDiv(leftValue, rightValue, "divTmp")
-                       : builder.CreateSDiv(leftValue, rightValue, "divTmp");
-    if (op == "==")
-        return isFloat ? builder.CreateFCmpOEQ(leftValue, rightValue, "eqTmp")
-                       : builder.CreateICmpEQ(leftValue, rightValue, "eqTmp");
-    if (op == "!=")
-        return isFloat ? builder.CreateFCmpONE(leftValue, rightValue, "neTmp")
-                       : builder.CreateICmpNE(leftValue, rightValue, "neTmp");
-    if (op == "<")
-        return isFloat ? builder.CreateFCmpOLT(leftValue, rightValue, "ltTmp")
-                       : builder.CreateICmpSLT(leftValue, rightValue, "ltTmp");
-    if (op == "<=")
-        return isFloat ? builder.CreateFCmpOLE(leftValue, rightValue, "leTmp")
-                       : builder.CreateICmpSLE(leftValue, rightValue, "leTmp");
-    if (op == ">")
-        return isFloat ? builder.CreateFCmpOGT(leftValue, rightValue, "gtTmp")
-                       : builder.CreateICmpSGT(leftValue, rightValue, "gtTmp");
-    if (op == ">=")
-        return isFloat ? builder.CreateFCmpOGE(leftValue, rightValue, "geTmp")
-                       : builder.CreateICmpSGE(leftValue, rightValue, "geTmp");
-    if (op == "%")
-        return builder.CreateSRem(leftValue, rightValue, "modTmp");
-    if (op == "&&")
-        return builder.CreateAnd(leftValue, rightValue, "andTmp");
-    if (op == "||")
-        return builder.CreateOr(leftValue, rightValue, "orTmp");
-    if (op == "<<")
-        return builder.CreateShl(leftValue, rightValue, "shlTmp");
-    if (op == ">>")
-        return builder.CreateAShr(leftValue, rightValue, "ashrTmp");
-    return nullptr;
+    switch (op) {
+        case OperatorKind::Add:
+            return isFloat ? builder.CreateFAdd(leftValue, rightValue, "addTmp")
+                           : builder.CreateAdd(leftValue, rightValue, "addTmp");
+        case OperatorKind::Subtract:
+            return isFloat ? builder.CreateFSub(leftValue, rightValue, "subTmp")
+                           : builder.CreateSub(leftValue, rightValue, "subTmp");
+        case OperatorKind::Multiply:
+            return isFloat ? builder.CreateFMul(leftValue, rightValue, "mulTmp")
+                           : builder.CreateMul(leftValue, rightValue, "mulTmp");
+        case OperatorKind::Divide:
+            return isFloat ? builder.CreateFDiv(leftValue, rightValue, "divTmp")
+                           : builder.CreateSDiv(leftValue, rightValue, "divTmp");
+        case OperatorKind::Equal:
+            return isFloat ? builder.CreateFCmpOEQ(leftValue, rightValue, "eqTmp")
+                           : builder.CreateICmpEQ(leftValue, rightValue, "eqTmp");
+        case OperatorKind::NotEqual:
+            return isFloat ? builder.CreateFCmpONE(leftValue, rightValue, "neTmp")
+                           : builder.CreateICmpNE(leftValue, rightValue, "neTmp");
+        case OperatorKind::Less:
+            return isFloat ? builder.CreateFCmpOLT(leftValue, rightValue, "ltTmp")
+                           : builder.CreateICmpSLT(leftValue, rightValue, "ltTmp");
+        case OperatorKind::LessEqual:
+            return isFloat ? builder.CreateFCmpOLE(leftValue, rightValue, "leTmp")
+                           : builder.CreateICmpSLE(leftValue, rightValue, "leTmp");
+        case OperatorKind::Greater:
+            return isFloat ? builder.CreateFCmpOGT(leftValue, rightValue, "gtTmp")
+                           : builder.CreateICmpSGT(leftValue, rightValue, "gtTmp");
+        case OperatorKind::GreaterEqual:
+            return isFloat ? builder.CreateFCmpOGE(leftValue, rightValue, "geTmp")
+                           : builder.CreateICmpSGE(leftValue, rightValue, "geTmp");
+        case OperatorKind::Modulo:
+            return builder.CreateSRem(leftValue, rightValue, "modTmp");
+        case OperatorKind::LogicalAnd:
+            return builder.CreateAnd(leftValue, rightValue, "andTmp");
+        case OperatorKind::LogicalOr:
+            return builder.CreateOr(leftValue, rightValue, "orTmp");
+        case OperatorKind::ShiftLeft:
+            return builder.CreateShl(leftValue, rightValue, "shlTmp");
+        case OperatorKind::ShiftRight:
+            return builder.CreateAShr(leftValue, rightValue, "ashrTmp");
+        default:
+            return nullptr;
+    }
 }
 
-auto CodeGenerator::getUnaryLLVM(const std::string &op, Value *value) -> Value * {
-    if (op == "-") {
-        if (value->getType()->isFloatingPointTy()) {
-            return builder.CreateFNeg(value, "fnegTmp"); // Negate floating-point value
-        }
-        if (value->getType()->isIntegerTy()) {
-            return builder.CreateNeg(value, "negTmp"); // Negate integer value
-        }
-        throw std::runtime_error("Unknown type for unary operator: " + op);
-    }
-    if (op == "!") {
-        return builder.CreateNot(value, "notTmp"); // Logical NOT
+auto CodeGenerator::getUnaryLLVM(const OperatorKind op, Value *value) -> Value * {
+    switch (op) {
+        case OperatorKind::Negate:
+            if (value->getType()->isFloatingPointTy()) {
+                return builder.CreateFNeg(value, "fnegTmp"); // Negate floating-point value
+            }
+            if (value->getType()->isIntegerTy()) {
+                return builder.CreateNeg(value, "negTmp"); // Negate integer value
+            }
+            throw std::runtime_error("Unknown type for unary operator: " + std::string(operatorKindToString(op)));
+        case OperatorKind::LogicalNot:
+            return builder.CreateNot(value, "notTmp"); // Logical NOT
+        default:
+            return nullptr;
     }
-    return nullptr;
 }
 
 constexpr int NUM_SIZE_BIT = 32;
 
-auto CodeGenerator::implicitConvert(Value *value, Type *targetType, const std::string &name) -> Value * {
+auto CodeGenerator::implicitConvert(Value *value, Type *targetType, const Twine &name) -> Value * {
 
     if (const Type *valueType = value->getType(); valueType != targetType) {
         if (valueType->isIntegerTy(NUM_SIZE_BIT) && targetType->isFloatTy()) {
@@ -0,0 +1,34 @@
+#include "../include/Diagnostics.h"
+
+#include <algorithm>
+
+#include "../include/Scanner.h"
+
+Diagnostics::Diagnostics(const SourceBuffer &source) : m_source(&source) {}
+
+void Diagnostics::error(const SourceSpan span, const std::string_view message) {
+    m_diagnostics.push_back({span, message});
+}
+
+void Diagnostics::print(std::ostream &out) const {
+    const std::string_view text = m_source->getText();
+    for (const Diagnostic &diagnostic : m_diagnostics) {
+        out << format(*m_source, diagnostic) << '\n';
+
+        // the line the span starts on, the underline stops at the end of that line
+        const std::uint32_t offset = diagnostic.span.offset;
+        const std::size_t   column = m_source->getPosition(offset).getColumn() - 1;
+        const char         *lineEnd = scanner::findLineEnd(text.data() + offset, text.data() + text.size());
+        const std::size_t   rest = std::max<std::size_t>(lineEnd - (text.data() + offset), 1);
+        const std::size_t   underline = std::clamp<std::size_t>(diagnostic.span.length, 1, rest);
+
+        out << "    " << text.substr(offset - column, column + (lineEnd - (text.data() + offset))) << '\n';
+        out << "    " << std::string(column, ' ') << '^' << std::string(underline - 1, '~') << '\n';
+    }
+}
+
+auto Diagnostics::format(const SourceBuffer &source, const Diagnostic &diagnostic) -> std::string {
+    const Position position = source.getPosition(diagnostic.span.offset);
+    return std::string(source.getName()) + ':' + std::to_string(position.getLine()) + ':' +
+           std::to_string(position.getColumn()) + ": error: " + std::string(diagnostic.message);
+}
@@ -0,0 +1,683 @@
+#include "../include/FlatAst.h"
+
+#include <array>
+#include <cstring>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include "../include/AstWalker.h"
+
+namespace {
+    // A .pcast file is a PcastHeader, a table of sectionCount PcastSections and the sections at aligned offsets.
+    // A section is the raw bytes of one array of the FlatAst as laid out by the writing host. The byte order and the
+    // element size of every section are checked on load, any other change to a record needs a new PCAST_VERSION.
+    constexpr std::array<char, 8> PCAST_MAGIC = {'P', 'C', 'A', 'S', 'T', '\0', '\r', '\n'};
+    constexpr std::uint32_t       PCAST_VERSION = 1;
+    constexpr std::uint32_t       PCAST_BYTE_ORDER = 0x01020304;
+    constexpr std::uint64_t       PCAST_ALIGNMENT = 8;
+
+    struct PcastHeader {
+        std::array<char, 8> magic;
+        std::uint32_t       version;
+        std::uint32_t       byteOrder;
+        std::uint32_t       sectionCount;
+        std::uint32_t       reserved;
+    };
+
+    struct PcastSection {
+        std::uint64_t offset; // from the start of the file
+        std::uint64_t count;  // of elements
+        std::uint64_t elementSize;
+    };
+
+    template <typename Array>
+    using ElementOf = std::ranges::range_value_t<Array>;
+
+    auto alignSection(const std::uint64_t offset) -> std::uint64_t {
+        return (offset + PCAST_ALIGNMENT - 1) / PCAST_ALIGNMENT * PCAST_ALIGNMENT;
+    }
+} // namespace
+
+// Numbers the nodes of a pointer tree in pre-order while walking it and fills in the record of a node once its
+// children have been numbered, the ids of finished children wait on a stack until their parent takes them
+class FlatAst::Builder {
+public:
+    explicit Builder(FlatAst &flat) : m_flat(flat) {}
+
+    void build(const Program &program);
+
+private:
+    FlatAst                                       &m_flat;
+    AstWalker                                      m_walker;
+    std::vector<FlatNodeId>                        m_open;     // nodes whose children are being walked
+    std::vector<FlatNodeId>                        m_finished; // finished nodes not yet taken by their parent
+    std::unordered_map<std::string_view, FlatText> m_texts;    // strings already in the pool
+
+    void enter(const AbstractNode &node);
+    void leave(const AbstractNode &node);
+
+    template <typename Record>
+    void open();
+
+    template <typename Record>
+    auto record(FlatNodeId id) -> Record &;
+
+    auto text(std::string_view spelling) -> FlatText;
+    auto list(std::span<const FlatNodeId> children) -> FlatRange;
+};
+
+auto FlatAst::fromProgram(const Program &program) -> FlatAst {
+    FlatAst flat;
+    Builder(flat).build(program);
+    return flat;
+}
+
+void FlatAst::Builder::build(const Program &program) {
+    // the walker hands out mutable nodes, the conversion doesn't modify them
+    m_walker.walk(
+            const_cast<Program &>(program),
+            [&](const AbstractNode &node, const AbstractNode *, std::size_t) {
+                enter(node);
+                return true;
+            },
+            [&](const AbstractNode &node, const AbstractNode *) { leave(node); });
+    m_flat.m_declarationTokens = program.declarationTokens;
+}
+
+void FlatAst::Builder::enter(const AbstractNode &node) {
+    m_open.push_back(static_cast<FlatNodeId>(m_flat.size()));
+    switch (node.getKind()) {
+        case NodeKind::Program:
+            open<FlatProgram>();
+            break;
+        case NodeKind::Block:
+            open<FlatBlock>();
+            break;
+        case NodeKind::FunctionDeclaration:
+            open<FlatFunctionDeclaration>();
+            break;
+        case NodeKind::FunctionCall:
+            open<FlatFunctionCall>();
+            break;
+        case NodeKind::VariableDeclaration:
+            open<FlatVariableDeclaration>();
+            break;
+        case NodeKind::Literal:
+            open<FlatLiteral>();
+            break;
+        case NodeKind::Reference:
+            open<FlatReference>();
+            break;
+        case NodeKind::BinaryOperation:
+            open<FlatBinaryOperation>();
+            break;
+        case NodeKind::UnaryOperation:
+            open<FlatUnaryOperation>();
+            break;
+        case NodeKind::IfStatement:
+            open<FlatIfStatement>();
+            break;
+        case NodeKind::WhileLoop:
+            open<FlatWhileLoop>();
+            break;
+        case NodeKind::ReturnStatement:
+            open<FlatReturnStatement>();
+            break;
+        case NodeKind::ExpressionStatement:
+            open<FlatExpressionStatement>();
+            break;
+        case NodeKind::Assignment:
+            open<FlatAssignment>();
+            break;
+        case NodeKind::Error:
+            open<FlatError>();
+            break;
+    }
+}
+
+void FlatAst::Builder::leave(const AbstractNode &node) {
+    const FlatNodeId id = m_open.back();
+    m_open.pop_back();
+
+    std::size_t count = 0;
+    ::forEachChild(node, [&](AbstractNode *) { count++; });
+    const std::span<const FlatNodeId> children = std::span<const FlatNodeId>(m_finished).last(count);
+
+    // ids of the children in the order forEachChild visits them, absent ones are skipped there. The fields of a
+    // braced record are evaluated in order, so the children are taken in that order as well.
+    std::size_t next = 0;
+    const auto child = [&](const AbstractNode *pointer) {
+        return pointer == nullptr ? INVALID_FLAT_NODE : children[next++];
+    };
+
+    switch (node.getKind()) {
+        case NodeKind::Program: {
+            const auto &program = static_cast<const Program &>(node);
+            record<FlatProgram>(id) = {text(program.name), child(program.body)};
+            break;
+        }
+        case NodeKind::Block:
+            record<FlatBlock>(id) = {list(children)};
+            break;
+        case NodeKind::FunctionDeclaration: {
+            const auto &function = static_cast<const FunctionDeclaration &>(node);
+            const FlatRange parameters{static_cast<std::uint32_t>(m_flat.m_parameters.size()),
+                                       static_cast<std::uint32_t>(function.parameters.size())};
+            for (const FunctionDeclaration::Parameter &parameter : function.parameters) {
+                m_flat.m_parameters.push_back({text(parameter.type), text(parameter.name), parameter.symbol});
+            }
+            record<FlatFunctionDeclaration>(id) = {text(function.name), function.symbol, parameters,
+                                                   child(function.body), text(function.returnType)};
+            break;
+        }
+        case NodeKind::FunctionCall: {
+            const auto &call = static_cast<const FunctionCall &>(node);
+            record<FlatFunctionCall>(id) = {text(call.name), call.symbol, list(children)};
+            break;
+        }
+        case NodeKind::VariableDeclaration: {
+            const auto &declaration = static_cast<const VariableDeclaration &>(node);
+            record<FlatVariableDeclaration>(id) = {text(declaration.type), text(declaration.name),
+                                                   declaration.symbol,      child(declaration.initializer),
+                                                   declaration.isPointer,   declaration.isReference};
+            break;
+        }
+        case NodeKind::Literal: {
+            const auto &literal = static_cast<const Literal &>(node);
+            record<FlatLiteral>(id) = {literal.number, text(literal.value), literal.literalKind};
+            break;
+        }
+        case NodeKind::Reference: {
+            const auto &reference = static_cast<const Reference &>(node);
+            record<FlatReference>(id) = {text(reference.name), reference.symbol, reference.isReference};
+            break;
+        }
+        case NodeKind::BinaryOperation: {
+            const auto &operation = static_cast<const BinaryOperation &>(node);
+            record<FlatBinaryOperation>(id) = {child(operation.left), child(operation.right), operation.operatorKind};
+            break;
+        }
+        case NodeKind::UnaryOperation: {
+            const auto &operation = static_cast<const UnaryOperation &>(node);
+            record<FlatUnaryOperation>(id) = {child(operation.operand), operation.operatorKind};
+            break;
+        }
+        case NodeKind::IfStatement: {
+            const auto &statement = static_cast<const IfStatement &>(node);
+            record<FlatIfStatement>(id) = {child(statement.condition), child(statement.thenBranch),
+                                           child(statement.elseBranch)};
+            break;
+        }
+        case NodeKind::WhileLoop: {
+            const auto &loop = static_cast<const WhileLoop &>(node);
+            record<FlatWhileLoop>(id) = {child(loop.condition), child(loop.body)};
+            break;
+        }
+        case NodeKind::ReturnStatement:
+            record<FlatReturnStatement>(id) = {child(static_cast<const ReturnStatement &>(node).expression)};
+            break;
+        case NodeKind::ExpressionStatement:
+            record<FlatExpressionStatement>(id) = {child(static_cast<const ExpressionStatement &>(node).expression)};
+            break;
+        case NodeKind::Assignment: {
+            const auto &assignment = static_cast<const Assignment &>(node);
+            record<FlatAssignment>(id) = {text(assignment.name), assignment.symbol, child(assignment.value),
+                                          assignment.isPointerDereference};
+            break;
+        }
+        case NodeKind::Error: {
+            const auto &error = static_cast<const ErrorNode &>(node);
+            record<FlatError>(id) = {error.offset, text(error.message)};
+            break;
+        }
+    }
+
+    m_finished.resize(m_finished.size() - count);
+    m_finished.push_back(id);
+}
+
+template <typename Record>
+void FlatAst::Builder::open() {
+    auto &records = std::get<std::vector<Record>>(m_flat.m_records);
+    m_flat.m_kinds.push_back(Record::KIND);
+    m_flat.m_slots.push_back(static_cast<std::uint32_t>(records.size()));
+    records.emplace_back();
+}
+
+template <typename Record>
+auto FlatAst::Builder::record(const FlatNodeId id) -> Record & {
+    return std::get<std::vector<Record>>(m_flat.m_records)[m_flat.m_slots[id]];
+}
+
+auto FlatAst::Builder::text(const std::string_view spelling) -> FlatText {
+    const auto [entry, inserted] = m_texts.try_emplace(spelling);
+    if (inserted) {
+        entry->second = {static_cast<std::uint32_t>(m_flat.m_text.size()), static_cast<std::uint32_t>(spelling.size())};
+        m_flat.m_text += spelling;
+    }
+    return entry->second;
+}
+
+auto FlatAst::Builder::list(const std::span<const FlatNodeId> children) -> FlatRange {
+    const FlatRange range{static_cast<std::uint32_t>(m_flat.m_children.size()),
+                          static_cast<std::uint32_t>(children.size())};
+    m_flat.m_children.insert(m_flat.m_children.end(), children.begin(), children.end());
+    return range;
+}
+
+auto FlatAst::toProgram() const -> std::unique_ptr<Program> {
+    auto                   arena = std::make_unique<AstArena>();
+    const std::string_view pool = arena->copyString(m_text);
+    const auto             textOf = [&](const FlatText text) { return pool.substr(text.offset, text.length); };
+
+    std::vector<AbstractNode *> nodes(size(), nullptr);
+    const auto node = [&](const FlatNodeId id) { return id == INVALID_FLAT_NODE ? nullptr : nodes[id]; };
+    const auto block = [&](const FlatNodeId id) { return static_cast<Block *>(node(id)); };
+
+    std::vector<AbstractNode *> list;
+    const auto                  nodeList = [&](const FlatRange range) {
+        list.clear();
+        for (const FlatNodeId child : getChildren(range)) {
+            list.push_back(nodes[child]);
+        }
+        return arena->copyArray(std::span<AbstractNode *const>(list));
+    };
+
+    // children have larger ids than their parent, so creating the nodes from the last id down finds every child
+    std::vector<FunctionDeclaration::Parameter> parameters;
+    for (FlatNodeId id = static_cast<FlatNodeId>(size()); id-- > 1;) {
+        switch (getKind(id)) {
+            case NodeKind::Program:
+                break; // only the root
+            case NodeKind::Block:
+                nodes[id] = arena->create<Block>(nodeList(get<FlatBlock>(id).statements));
+                break;
+            case NodeKind::FunctionDeclaration: {
+                const auto &function = get<FlatFunctionDeclaration>(id);
+                parameters.clear();
+                for (const FlatParameter &parameter : getParameters(function.parameters)) {
+                    parameters.emplace_back(textOf(parameter.type), textOf(parameter.name), parameter.symbol);
+                }
+                nodes[id] = arena->create<FunctionDeclaration>(
+                        textOf(function.name), function.symbol,
+                        arena->copyArray(std::span<const FunctionDeclaration::Parameter>(parameters)),
+                        block(function.body), textOf(function.returnType));
+                break;
+            }
+            case NodeKind::FunctionCall: {
+                const auto &call = get<FlatFunctionCall>(id);
+                nodes[id] = arena->create<FunctionCall>(textOf(call.name), call.symbol, nodeList(call.arguments));
+                break;
+            }
+            case NodeKind::VariableDeclaration: {
+                const auto &declaration = get<FlatVariableDeclaration>(id);
+                nodes[id] = arena->create<VariableDeclaration>(textOf(declaration.type), textOf(declaration.name),
+                                                               declaration.symbol, declaration.isPointer,
+                                                               declaration.isReference, node(declaration.initializer));
+                break;
+            }
+            case NodeKind::Literal: {
+                const auto &literal = get<FlatLiteral>(id);
+                nodes[id] = arena->create<Literal>(literal.literalKind, textOf(literal.value), literal.number);
+                break;
+            }
+            case NodeKind::Reference: {
+                const auto &reference = get<FlatReference>(id);
+                nodes[id] = arena->create<Reference>(textOf(reference.name), reference.symbol, reference.isReference);
+                break;
+            }
+            case NodeKind::BinaryOperation: {
+                const auto &operation = get<FlatBinaryOperation>(id);
+                nodes[id] = arena->create<BinaryOperation>(node(operation.left), operation.operatorKind,
+                                                           node(operation.right));
+                break;
+            }
+            case NodeKind::UnaryOperation: {
+                const auto &operation = get<FlatUnaryOperation>(id);
+                nodes[id] = arena->create<UnaryOperation>(node(operation.operand), operation.operatorKind);
+                break;
+            }
+            case NodeKind::IfStatement: {
+                const auto &statement = get<FlatIfStatement>(id);
+                nodes[id] = arena->create<IfStatement>(node(statement.condition), block(statement.thenBranch),
+                                                       block(statement.elseBranch));
+                break;
+            }
+            case NodeKind::WhileLoop: {
+                const auto &loop = get<FlatWhileLoop>(id);
+                nodes[id] = arena->create<WhileLoop>(node(loop.condition), block(loop.body));
+                break;
+            }
+            case NodeKind::ReturnStatement:
+                nodes[id] = arena->create<ReturnStatement>(node(get<FlatReturnStatement>(id).expression));
+                break;
+            case NodeKind::ExpressionStatement:
+                nodes[id] = arena->create<ExpressionStatement>(node(get<FlatExpressionStatement>(id).expression));
+                break;
+            case NodeKind::Assignment: {
+                const auto &assignment = get<FlatAssignment>(id);
+                nodes[id] = arena->create<Assignment>(textOf(assignment.name), assignment.symbol,
+                                                      node(assignment.value), assignment.isPointerDereference);
+                break;
+            }
+            case NodeKind::Error: {
+                const auto &error = get<FlatError>(id);
+                nodes[id] = arena->create<ErrorNode>(error.offset, textOf(error.message));
+                break;
+            }
+        }
+    }
+
+    const FlatProgram                     &program = get<FlatProgram>(0);
+    const std::string_view                 name = textOf(program.name);
+    Block                                 *body = block(program.body);
+    std::vector<std::unique_ptr<AstArena>> arenas;
+    arenas.push_back(std::move(arena));
+    return std::make_unique<Program>(name, body, m_declarationTokens, std::move(arenas));
+}
+
+auto FlatAst::getStatistics() const -> AstStatistics {
+    AstStatistics statistics;
+    for (const NodeKind kind : m_kinds) {
+        statistics.nodeCounts[static_cast<std::size_t>(kind)]++;
+    }
+    statistics.nodeBytes = m_kinds.size() * (sizeof(NodeKind) + sizeof(std::uint32_t));
+    statistics.reservedBytes = m_kinds.capacity() * sizeof(NodeKind) + m_slots.capacity() * sizeof(std::uint32_t);
+    std::apply(
+            [&](const auto &...records) {
+                ((statistics.nodeBytes += records.size() * sizeof(records[0]),
+                  statistics.reservedBytes += records.capacity() * sizeof(records[0])),
+                 ...);
+            },
+            m_records);
+    statistics.listBytes = m_children.size() * sizeof(FlatNodeId) + m_parameters.size() * sizeof(FlatParameter);
+    statistics.stringBytes = m_text.size();
+    statistics.reservedBytes += m_children.capacity() * sizeof(FlatNodeId) +
+                                m_parameters.capacity() * sizeof(FlatParameter) + m_text.capacity();
+    return statistics;
+}
+
+template <typename Self, typename Function>
+void FlatAst::forEachArray(Self &flat, Function &&function) {
+    function(flat.m_kinds);
+    function(flat.m_slots);
+    std::apply([&](auto &...records) { (function(records), ...); }, flat.m_records);
+    function(flat.m_children);
+    function(flat.m_parameters);
+    function(flat.m_text);
+    function(flat.m_declarationTokens);
+}
+
+template <typename Self, typename Function>
+void FlatAst::forEachSymbol(Self &flat, Function &&function) {
+    const auto each = [&](auto &records) {
+        for (auto &record : records) {
+            function(record.symbol, record.name);
+        }
+    };
+    each(std::get<std::vector<FlatFunctionDeclaration>>(flat.m_records));
+    each(std::get<std::vector<FlatFunctionCall>>(flat.m_records));
+    each(std::get<std::vector<FlatVariableDeclaration>>(flat.m_records));
+    each(std::get<std::vector<FlatReference>>(flat.m_records));
+    each(std::get<std::vector<FlatAssignment>>(flat.m_records));
+    each(flat.m_parameters);
+}
+
+void FlatAst::save(const std::string &path) const {
+    // spelling of every symbol id in the tree, ids that don't occur in it are left empty
+    std::vector<FlatText> symbols;
+    forEachSymbol(*this, [&](const SymbolId symbol, const FlatText name) {
+        if (symbol != INVALID_SYMBOL) {
+            symbols.resize(std::max<std::size_t>(symbols.size(), symbol + 1));
+            symbols[symbol] = name;
+        }
+    });
+
+    std::vector<PcastSection>           table;
+    std::vector<std::span<const char>> contents;
+    const auto                          addSection = [&](const auto &array) {
+        using Element = ElementOf<decltype(array)>;
+        static_assert(std::is_trivially_copyable_v<Element>);
+        table.push_back({0, array.size(), sizeof(Element)});
+        contents.emplace_back(reinterpret_cast<const char *>(array.data()), array.size() * sizeof(Element));
+    };
+    forEachArray(*this, addSection);
+    addSection(symbols);
+
+    std::uint64_t offset = alignSection(sizeof(PcastHeader) + table.size() * sizeof(PcastSection));
+    for (PcastSection &section : table) {
+        section.offset = offset;
+        offset = alignSection(offset + section.count * section.elementSize);
+    }
+
+    std::error_code      error;
+    llvm::raw_fd_ostream out(path, error);
+    if (error) {
+        throw std::runtime_error("Failed to write file " + path + ": " + error.message());
+    }
+
+    const PcastHeader header{PCAST_MAGIC, PCAST_VERSION, PCAST_BYTE_ORDER, static_cast<std::uint32_t>(table.size()), 0};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(PcastSection));
+    for (std::size_t index = 0; index < table.size(); ++index) {
+        out.write_zeros(table[index].offset - out.tell());
+        out.write(contents[index].data(), contents[index].size());
+    }
+
+    out.close();
+    if (out.has_error()) {
+        error = out.error();
+        out.clear_error();
+        throw std::runtime_error("Failed to write file " + path + ": " + error.message());
+    }
+}
+
+auto FlatAst::load(const std::string &path, StringInterner &interner) -> FlatAst {
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        throw std::runtime_error("Failed to open file " + path + ": " + buffer.getError().message());
+    }
+    const char         *file = (*buffer)->getBufferStart();
+    const std::uint64_t fileSize = (*buffer)->getBufferSize();
+    const auto          invalid = [&](const std::string &reason) {
+        return std::runtime_error("Invalid AST file " + path + ": " + reason);
+    };
+
+    PcastHeader header{};
+    if (fileSize < sizeof(header)) {
+        throw invalid("truncated header");
+    }
+    std::memcpy(&header, file, sizeof(header));
+    if (header.magic != PCAST_MAGIC) {
+        throw invalid("not a .pcast file");
+    }
+    if (header.version != PCAST_VERSION) {
+        throw invalid("version " + std::to_string(header.version) + ", expected " + std::to_string(PCAST_VERSION));
+    }
+    if (header.byteOrder != PCAST_BYTE_ORDER) {
+        throw invalid("written with another byte order");
+    }
+
+    FlatAst               flat;
+    std::vector<FlatText> symbols;
+    std::uint32_t         index = 0;
+    const auto            readSection = [&](auto &array) {
+        using Element = ElementOf<decltype(array)>;
+        const std::uint64_t entry = sizeof(header) + std::uint64_t{index} * sizeof(PcastSection);
+        if (index++ >= header.sectionCount || entry + sizeof(PcastSection) > fileSize) {
+            throw invalid("truncated section table");
+        }
+        PcastSection section{};
+        std::memcpy(&section, file + entry, sizeof(section));
+        if (section.elementSize != sizeof(Element)) {
+            throw invalid("section " + std::to_string(index - 1) + " has another layout");
+        }
+        if (section.offset > fileSize || section.count > (fileSize - section.offset) / sizeof(Element)) {
+            throw invalid("section " + std::to_string(index - 1) + " exceeds the file");
+        }
+        array.resize(section.count);
+        std::memcpy(array.data(), file + section.offset, section.count * sizeof(Element));
+    };
+    forEachArray(flat, readSection);
+    readSection(symbols);
+    if (index != header.sectionCount) {
+        throw invalid("unexpected number of sections");
+    }
+
+    try {
+        flat.validate(symbols);
+    } catch (const std::runtime_error &e) {
+        throw invalid(e.what());
+    }
+
+    // symbol ids of the file to ids of the interner, the identity if the file was written from a fresh interner and
+    // is loaded into one, then nothing in the tree has to change
+    std::vector<SymbolId> symbolIds(symbols.size(), INVALID_SYMBOL);
+    bool                  identity = true;
+    for (SymbolId symbol = 0; symbol < symbols.size(); ++symbol) {
+        if (symbols[symbol].length != 0) {
+            symbolIds[symbol] = interner.intern(flat.getText(symbols[symbol]));
+            identity = identity && symbolIds[symbol] == symbol;
+        }
+    }
+    if (!identity) {
+        forEachSymbol(flat, [&](SymbolId &symbol, FlatText) {
+            if (symbol != INVALID_SYMBOL) {
+                symbol = symbolIds[symbol];
+            }
+        });
+    }
+    return flat;
+}
+
+void FlatAst::validate(const std::span<const FlatText> symbols) const {
+    const auto require = [](const bool condition, const char *what) {
+        if (!condition) {
+            throw std::runtime_error(what);
+        }
+    };
+    const auto validText = [&](const FlatText text) {
+        return std::uint64_t{text.offset} + text.length <= m_text.size();
+    };
+    const auto validRange = [](const FlatRange range, const std::size_t poolSize) {
+        return std::uint64_t{range.first} + range.count <= poolSize;
+    };
+    const auto validSymbol = [&](const SymbolId symbol) {
+        return symbol == INVALID_SYMBOL || (symbol < symbols.size() && symbols[symbol].length != 0);
+    };
+
+    require(std::ranges::all_of(symbols, validText), "symbol spelling out of bounds");
+    require(!m_kinds.empty() && m_kinds.size() == m_slots.size() && m_kinds.size() < INVALID_FLAT_NODE,
+            "malformed node table");
+
+    // slots are handed out per kind in pre-order, the n-th node of a kind has slot n and every record one node
+    std::array<std::uint32_t, NODE_KIND_COUNT> recordCounts{};
+    for (FlatNodeId id = 0; id < size(); ++id) {
+        const auto kind = static_cast<std::size_t>(m_kinds[id]);
+        require(kind < NODE_KIND_COUNT, "unknown node kind");
+        require((id == 0) == (m_kinds[id] == NodeKind::Program), "the program is not the root");
+        require(m_slots[id] == recordCounts[kind]++, "node slots out of order");
+    }
+    std::apply(
+            [&](const auto &...records) {
+                (require(records.size() == recordCounts[static_cast<std::size_t>(ElementOf<decltype(records)>::KIND)],
+                         "records without a node"),
+                 ...);
+            },
+            m_records);
+
+    const auto isBlock = [&](const FlatNodeId parent, const FlatNodeId child) {
+        return child == INVALID_FLAT_NODE || (child > parent && child < size() && m_kinds[child] == NodeKind::Block);
+    };
+    const auto isOperator = [](const OperatorKind kind, const OperatorKind first, const OperatorKind last) {
+        return kind >= first && kind <= last;
+    };
+
+    // children come after their parent and have no other parent, which makes the nodes a tree
+    std::vector<bool> hasParent(size(), false);
+    for (FlatNodeId id = 0; id < size(); ++id) {
+        switch (getKind(id)) {
+            case NodeKind::Program: {
+                const auto &program = get<FlatProgram>(id);
+                require(validText(program.name) && isBlock(id, program.body), "malformed program");
+                break;
+            }
+            case NodeKind::Block:
+                require(validRange(get<FlatBlock>(id).statements, m_children.size()), "malformed block");
+                break;
+            case NodeKind::FunctionDeclaration: {
+                const auto &function = get<FlatFunctionDeclaration>(id);
+                require(validText(function.name) && validText(function.returnType) && validSymbol(function.symbol) &&
+                                validRange(function.parameters, m_parameters.size()) && isBlock(id, function.body),
+                        "malformed function declaration");
+                for (const FlatParameter &parameter : getParameters(function.parameters)) {
+                    require(validText(parameter.type) && validText(parameter.name) && validSymbol(parameter.symbol),
+                            "malformed parameter");
+                }
+                break;
+            }
+            case NodeKind::FunctionCall: {
+                const auto &call = get<FlatFunctionCall>(id);
+                require(validText(call.name) && validSymbol(call.symbol) &&
+                                validRange(call.arguments, m_children.size()),
+                        "malformed function call");
+                break;
+            }
+            case NodeKind::VariableDeclaration: {
+                const auto &declaration = get<FlatVariableDeclaration>(id);
+                require(validText(declaration.type) && validText(declaration.name) && validSymbol(declaration.symbol),
+                        "malformed variable declaration");
+                break;
+            }
+            case NodeKind::Literal: {
+                const auto &literal = get<FlatLiteral>(id);
+                require(validText(literal.value) && literal.literalKind <= LiteralKind::String, "malformed literal");
+                break;
+            }
+            case NodeKind::Reference: {
+                const auto &reference = get<FlatReference>(id);
+                require(validText(reference.name) && validSymbol(reference.symbol), "malformed reference");
+                break;
+            }
+            case NodeKind::BinaryOperation:
+                require(isOperator(get<FlatBinaryOperation>(id).operatorKind, OperatorKind::Add,
+                                   OperatorKind::ShiftRight),
+                        "malformed binary operation");
+                break;
+            case NodeKind::UnaryOperation:
+                require(isOperator(get<FlatUnaryOperation>(id).operatorKind, OperatorKind::Negate,
+                                   OperatorKind::LogicalNot),
+                        "malformed unary operation");
+                break;
+            case NodeKind::IfStatement: {
+                const auto &statement = get<FlatIfStatement>(id);
+                require(isBlock(id, statement.thenBranch) && isBlock(id, statement.elseBranch),
+                        "malformed if statement");
+                break;
+            }
+            case NodeKind::WhileLoop:
+                require(isBlock(id, get<FlatWhileLoop>(id).body), "malformed while loop");
+                break;
+            case NodeKind::ReturnStatement:
+            case NodeKind::ExpressionStatement:
+                break;
+            case NodeKind::Assignment: {
+                const auto &assignment = get<FlatAssignment>(id);
+                require(validText(assignment.name) && validSymbol(assignment.symbol), "malformed assignment");
+                break;
+            }
+            case NodeKind::Error:
+                require(validText(get<FlatError>(id).message), "malformed error");
+                break;
+        }
+
+        forEachChild(id, [&](const FlatNodeId child) {
+            require(child > id && child < size() && !hasParent[child], "the nodes are not a tree");
+            hasParent[child] = true;
+        });
+    }
+}
@@ -1,33 +1,365 @@
 #include "../include/Parser.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
 
 #include "../include/AbstractSyntaxTree.h"
+#include "../include/FlatAst.h"
+
+namespace {
+    // Binding powers of a token kind in prefix, infix and postfix position, 0 where it cannot appear there, and
+    // the operators it stands for. The right operand of an infix operator is parsed with infixRight: infixLeft + 1
+    // groups equal operators to the left, infixRight == infixLeft would group them to the right. Postfix operators
+    // bind tighter than prefix ones, -f(x) negates the call.
+    struct BindingPower {
+        std::uint8_t prefix = 0;
+        std::uint8_t infixLeft = 0;
+        std::uint8_t infixRight = 0;
+        std::uint8_t postfix = 0;
+        OperatorKind prefixOperator{};
+        OperatorKind infixOperator{};
+    };
+
+    constexpr auto BINDING_POWERS = [] {
+        std::array<BindingPower, TOKEN_KIND_COUNT> table{};
+        const auto leftAssociative = [&](const TokenKind kind, const std::uint8_t power, const OperatorKind op) {
+            table[static_cast<std::size_t>(kind)].infixLeft = power;
+            table[static_cast<std::size_t>(kind)].infixRight = power + 1;
+            table[static_cast<std::size_t>(kind)].infixOperator = op;
+        };
+        const auto prefix = [&](const TokenKind kind, const std::uint8_t power, const OperatorKind op) {
+            table[static_cast<std::size_t>(kind)].prefix = power;
+            table[static_cast<std::size_t>(kind)].prefixOperator = op;
+        };
+
+        leftAssociative(TokenKind::PipePipe, 2, OperatorKind::LogicalOr);
+        leftAssociative(TokenKind::AmpAmp, 3, OperatorKind::LogicalAnd);
+        leftAssociative(TokenKind::Pipe, 4, OperatorKind::BitwiseOr);
+        leftAssociative(TokenKind::Caret, 5, OperatorKind::BitwiseXor);
+        leftAssociative(TokenKind::Amp, 6, OperatorKind::BitwiseAnd);
+        leftAssociative(TokenKind::EqualEqual, 7, OperatorKind::Equal);
+        leftAssociative(TokenKind::BangEqual, 7, OperatorKind::NotEqual);
+        leftAssociative(TokenKind::Less, 8, OperatorKind::Less);
+        leftAssociative(TokenKind::Greater, 8, OperatorKind::Greater);
+        leftAssociative(TokenKind::LessEqual, 8, OperatorKind::LessEqual);
+        leftAssociative(TokenKind::GreaterEqual, 8, OperatorKind::GreaterEqual);
+        leftAssociative(TokenKind::LessLess, 9, OperatorKind::ShiftLeft);
+        leftAssociative(TokenKind::GreaterGreater, 9, OperatorKind::ShiftRight);
+        leftAssociative(TokenKind::Plus, 10, OperatorKind::Add);
+        leftAssociative(TokenKind::Minus, 10, OperatorKind::Subtract);
+        leftAssociative(TokenKind::Star, 11, OperatorKind::Multiply);
+        leftAssociative(TokenKind::Slash, 11, OperatorKind::Divide);
+        leftAssociative(TokenKind::Percent, 11, OperatorKind::Modulo);
+
+        prefix(TokenKind::Minus, 12, OperatorKind::Negate);
+        prefix(TokenKind::Bang, 12, OperatorKind::LogicalNot);
+
+        table[static_cast<std::size_t>(TokenKind::LeftParen)].postfix = 13; // callee(argument, ...)
+        return table;
+    }();
+
+    // The operators print as the tokens they are parsed from
+    static_assert([] {
+        for (std::size_t kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+            const BindingPower &power = BINDING_POWERS[kind];
+            const auto          spelling = tokenKindToString(static_cast<TokenKind>(kind));
+            if ((power.infixLeft != 0 && operatorKindToString(power.infixOperator) != spelling) ||
+                (power.prefix != 0 && operatorKindToString(power.prefixOperator) != spelling)) {
+                return false;
+            }
+        }
+        return true;
+    }(), "BINDING_POWERS maps a token to an operator of another spelling");
+
+    // Every infix operator of the table is a binary operator of the lexer and the other way around
+    static_assert([] {
+        for (std::size_t kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+            if ((BINDING_POWERS[kind].infixLeft != 0) != isBinaryOperator(static_cast<TokenKind>(kind))) {
+                return false;
+            }
+        }
+        return true;
+    }(), "BINDING_POWERS is out of sync with BINARY_OPERATORS");
 
-Parser::Parser() = default;
+    constexpr auto bindingPowerOf(const TokenKind kind) -> const BindingPower & {
+        return BINDING_POWERS[static_cast<std::size_t>(kind)];
+    }
 
-auto Parser::parse(std::vector<Token> tokens) -> std::unique_ptr<Program> {
-    m_tokens = std::move(tokens);
+    // Messages of failed consume() calls, built once so diagnostics can keep views into them
+    const auto EXPECTED_MESSAGES = [] {
+        std::array<std::string, TOKEN_KIND_COUNT> messages;
+        for (std::size_t kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+            messages[kind] = "expected " + std::string(tokenKindToString(static_cast<TokenKind>(kind)));
+        }
+        return messages;
+    }();
+
+    // Token ranges of the top-level declarations from index begin on. A function declaration ends with the '}'
+    // matching the first '{' after its start, there are no braces in its header. Empty if the braces don't match,
+    // tokens after the last '}' form a range of their own that fails to parse.
+    auto findDeclarations(const TokenStore &tokens, const std::size_t begin)
+            -> std::vector<std::pair<std::size_t, std::size_t>> {
+        std::vector<std::pair<std::size_t, std::size_t>> declarations;
+        std::size_t                                      start = begin;
+        std::size_t                                      depth = 0;
+        for (std::size_t index = begin; index < tokens.size(); ++index) {
+            if (const TokenKind kind = tokens.getKind(index); kind == TokenKind::LeftBrace) {
+                depth++;
+            } else if (kind == TokenKind::RightBrace) {
+                if (depth == 0) {
+                    return {};
+                }
+                if (--depth == 0) {
+                    declarations.emplace_back(start, index + 1);
+                    start = index + 1;
+                }
+            }
+        }
+        if (start < tokens.size()) {
+            declarations.emplace_back(start, tokens.size());
+        }
+        return declarations;
+    }
+} // namespace
+
+Parser::Parser(Diagnostics *diagnostics) : m_diagnostics(diagnostics) {}
+
+auto Parser::parse(TokenStream &tokens) -> std::unique_ptr<Program> {
+    m_tokens = &tokens;
+    m_previous = Token();
+    m_panic = nullptr;
+    m_consumed = 0;
+    m_nodeStack.clear();
+    m_parameterStack.clear();
+    m_expressionStack.clear();
+    m_blockStack.clear();
     return parseProgram();
 }
 
+auto Parser::reparse(std::unique_ptr<Program> program, const TokenStore &tokens, const TokenRange &changed)
+        -> std::unique_ptr<Program> {
+    const std::vector<DeclarationTokens> &previous = program->declarationTokens;
+    const std::span<AbstractNode *>       statements = program->body->statements;
+
+    // the header "program name;" has to be untouched and error free
+    if (previous.empty() || changed.begin < previous.front().begin || previous.front().begin != 3 ||
+        tokens.getKind(0) != TokenKind::Program || tokens.getKind(1) != TokenKind::Identifier ||
+        tokens.getKind(2) != TokenKind::Semicolon) {
+        return parse(tokens);
+    }
+
+    // An error free declaration that doesn't overlap the change is kept, shifted if it follows the change. Such a
+    // declaration consumed exactly its own tokens and started with the parser in its initial state, so whenever the
+    // new parse reaches a declaration boundary at its (shifted) start, parsing it again would give the same tree.
+    const std::int64_t delta = static_cast<std::int64_t>(changed.newEnd) - static_cast<std::int64_t>(changed.oldEnd);
+    const auto         keptRange = [&](const std::size_t index) -> std::optional<DeclarationTokens> {
+        DeclarationTokens range = previous[index];
+        if (range.hasErrors || (range.end > changed.begin && range.begin < changed.oldEnd)) {
+            return std::nullopt;
+        }
+        if (range.begin >= changed.oldEnd) {
+            range.begin = static_cast<std::uint32_t>(range.begin + delta);
+            range.end = static_cast<std::uint32_t>(range.end + delta);
+        }
+        return range;
+    };
+    std::size_t next = 0; // the first previous declaration that could still be kept
+    const auto  keptAt = [&](const std::size_t position) -> std::optional<DeclarationTokens> {
+        for (; next < previous.size(); ++next) {
+            if (const auto range = keptRange(next); range && range->begin >= position) {
+                return range->begin == position ? range : std::nullopt;
+            }
+        }
+        return std::nullopt;
+    };
+
+    auto arena = std::make_unique<AstArena>();
+    m_arena = arena.get();
+    m_panic = nullptr;
+    m_nodeStack.clear();
+    m_parameterStack.clear();
+    m_expressionStack.clear();
+    m_blockStack.clear();
+
+    std::vector<DeclarationTokens> declarationTokens;
+    std::vector<bool>              kept(previous.size(), false);
+    for (std::size_t position = previous.front().begin; position < tokens.size();) {
+        if (const auto range = keptAt(position)) {
+            m_nodeStack.push_back(statements[next]);
+            kept[next] = true;
+            declarationTokens.push_back(*range);
+            position = range->end;
+            continue;
+        }
+
+        // parse from here up to the next declaration that is kept
+        TokenStoreStream stream(tokens, position, tokens.size());
+        m_tokens = &stream;
+        m_previous = Token();
+        m_consumed = 0;
+        do {
+            parseTopLevelDeclaration(position, declarationTokens);
+        } while (!isAtEnd() && !keptAt(position + m_consumed));
+        position += m_consumed;
+        m_tokens = nullptr;
+    }
+
+    // the replaced declarations and the old body stay in their arenas until the caller compacts the tree
+    for (std::size_t index = 0; index < statements.size(); ++index) {
+        if (!kept[index]) {
+            program->deadBytes += getSubtreeStatistics(*statements[index]).getUsedBytes();
+        }
+    }
+    program->deadBytes += sizeof(Block) + statements.size_bytes();
+
+    program->body = m_arena->create<Block>(popNodes(0));
+    program->declarationTokens = std::move(declarationTokens);
+    program->arenas.push_back(std::move(arena));
+    m_arena = nullptr;
+    return program;
+}
+
+auto Parser::compact(const Program &program) -> std::unique_ptr<Program> {
+    // a FlatAst holds nothing but the tree, converting it back allocates exactly the live nodes
+    return FlatAst::fromProgram(program).toProgram();
+}
+
+auto Parser::parse(const TokenStore &tokens) -> std::unique_ptr<Program> {
+    TokenStoreStream stream(tokens);
+    return parse(stream);
+}
+
+auto Parser::parseParallel(const TokenStore &tokens, unsigned int threads) -> std::unique_ptr<Program> {
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    // program name;
+    if (tokens.getKind(0) != TokenKind::Program || tokens.getKind(1) != TokenKind::Identifier ||
+        tokens.getKind(2) != TokenKind::Semicolon) {
+        return parse(tokens);
+    }
+    const auto        declarations = findDeclarations(tokens, 3);
+    const std::size_t workerCount =
+            std::min<std::size_t>({threads, declarations.size(), tokens.size() / MIN_TOKENS_PER_WORKER});
+    if (workerCount <= 1) {
+        return parse(tokens);
+    }
+
+    // Every worker takes a contiguous run of declarations with about the same number of tokens, so its arena holds
+    // them in source order
+    std::vector<std::size_t> firstDeclaration(workerCount + 1, declarations.size());
+    for (std::size_t worker = 0, declaration = 0; worker < workerCount; ++worker) {
+        const std::size_t tokenLimit = 3 + (tokens.size() - 3) * worker / workerCount;
+        while (declaration < declarations.size() && declarations[declaration].first < tokenLimit) {
+            declaration++;
+        }
+        firstDeclaration[worker] = declaration;
+    }
+
+    std::vector<std::unique_ptr<AstArena>> arenas;
+    for (std::size_t worker = 0; worker <= workerCount; ++worker) {
+        arenas.push_back(std::make_unique<AstArena>());
+    }
+    std::vector<AbstractNode *> nodes(declarations.size());
+    std::atomic<bool>           failed = false;
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t worker = 0; worker < workerCount; ++worker) {
+            workers.emplace_back([&, worker] {
+                Parser parser;
+                parser.m_arena = arenas[worker + 1].get();
+                try {
+                    for (std::size_t index = firstDeclaration[worker];
+                         index < firstDeclaration[worker + 1] && !failed.load(std::memory_order_relaxed); ++index) {
+                        nodes[index] = parser.parseDeclaration(tokens, declarations[index].first,
+                                                               declarations[index].second);
+                    }
+                } catch (...) {
+                    failed = true;
+                }
+            });
+        }
+    }
+    if (failed) {
+        return parse(tokens); // reports the first error in source order
+    }
+
+    AstArena &arena = *arenas.front();
+    Block    *body = arena.create<Block>(arena.copyArray(std::span<AbstractNode *const>(nodes)));
+    std::vector<DeclarationTokens> declarationTokens;
+    declarationTokens.reserve(declarations.size());
+    for (const auto &[begin, end] : declarations) {
+        declarationTokens.push_back({static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end), false});
+    }
+    const std::string_view programName = tokens.getInterner().getSpelling(tokens.getSymbol(1));
+    return std::make_unique<Program>(programName, body, std::move(declarationTokens), std::move(arenas));
+}
+
+auto Parser::parseDeclaration(const TokenStore &tokens, const std::size_t begin, const std::size_t end)
+        -> AbstractNode * {
+    // a declaration found by brace matching, the parse has to end exactly at its closing brace
+    TokenStoreStream stream(tokens, begin, end);
+    m_tokens = &stream;
+    m_previous = Token();
+
+    AbstractNode *declaration = parseDeclaration();
+    if (!isAtEnd()) {
+        throwError("unexpected token after declaration");
+    }
+    m_tokens = nullptr;
+    return declaration;
+}
+
 auto Parser::parseProgram() -> std::unique_ptr<Program> {
+    // the arena is owned by the parser until the Program takes it over
+    auto arena = std::make_unique<AstArena>();
+    m_arena = arena.get();
+
     // program name
-    consume(TokenType::Keyword, "program");
-    const std::string programName = peek().getValue();
-    consume(TokenType::Identifier);
-    consume(";");
+    consume(TokenKind::Program);
+    const std::string_view programName = spellingOf(peek());
+    consume(TokenKind::Identifier);
+    consume(TokenKind::Semicolon);
+    if (m_panic != nullptr) {
+        synchronizeDeclaration(false);
+    }
 
     // program body
-    std::unique_ptr<Block> body = std::make_unique<Block>();
+    const std::size_t              mark = m_nodeStack.size();
+    std::vector<DeclarationTokens> declarationTokens;
     while (!isAtEnd()) {
-        body->statements.push_back(parseDeclaration());
+        parseTopLevelDeclaration(0, declarationTokens);
     }
+    Block *body = m_arena->create<Block>(popNodes(mark));
+
+    m_arena = nullptr;
+    std::vector<std::unique_ptr<AstArena>> arenas;
+    arenas.push_back(std::move(arena));
+    return std::make_unique<Program>(programName, body, std::move(declarationTokens), std::move(arenas));
+}
 
-    return std::make_unique<Program>(programName, std::move(body));
-};
+void Parser::parseTopLevelDeclaration(const std::size_t streamStart, std::vector<DeclarationTokens> &ranges) {
+    // the declaration's token range includes the tokens skipped to recover from an error in it
+    const std::size_t consumed = m_consumed;
+    const std::size_t errorCount = m_errorCount;
 
-auto Parser::parseDeclaration() -> std::unique_ptr<AbstractNode> {
+    AbstractNode *declaration = parseDeclaration();
+    if (m_panic != nullptr) {
+        declaration = m_panic;
+        synchronizeDeclaration(consumed == m_consumed);
+    }
+    m_nodeStack.push_back(declaration);
+    ranges.push_back({static_cast<std::uint32_t>(streamStart + consumed),
+                      static_cast<std::uint32_t>(streamStart + m_consumed), m_errorCount != errorCount});
+}
+
+auto Parser::parseDeclaration() -> AbstractNode * {
     // Statements:
     // - Function declaration can start with either
     //  - (             # params and return type explicitly defined
@@ -37,177 +369,170 @@ auto Parser::parseDeclaration() -> std::unique_ptr<AbstractNode> {
     // - Variable declaration starts with
     //  - identifier    # variable declaration with explicit typing
 
-    if (match(TokenType::Symbol, "(") || match(TokenType::Keyword, "func") ||
-        match(TokenType::Identifier) && peekNext().getValue() == "{") {
-
+    if (startsDeclaration()) {
         return parseFunctionDeclaration();
     }
     /*
-    if (match(TokenType::Identifier)) { // the type of the variable
+    if (match(TokenKind::Identifier)) { // the type of the variable
         return parseVariableDeclaration();
     }
     */
 
-    throwError("Parser: invalid statement");
+    return reportError("Parser: invalid statement");
 }
 
-auto Parser::parseFunctionDeclaration() -> std::unique_ptr<FunctionDeclaration> {
+auto Parser::parseFunctionDeclaration() -> FunctionDeclaration * {
     // func is consumed, so can only be
     // - identifier {  # params and return type inferred (void)
     // - (             # params and return type explicitly defined
 
-    std::vector<FunctionDeclaration::Parameter> parameters;
-    std::string                                 returnType = "void";
+    std::string_view returnType = "void";
 
-    if (match(TokenType::Symbol, "(")) {
+    if (match(TokenKind::LeftParen)) {
         //  - ( type identifier, ... ) -> return_type   # params and return type explicitly defined
 
         advance(); // consume "("
 
-        while (!match(TokenType::Symbol, ")")) {
-            const std::string type = peek().getValue();
-            consume(TokenType::Identifier);
+        while (!match(TokenKind::RightParen) && m_panic == nullptr) {
+            const std::string_view type = spellingOf(peek());
+            consume(TokenKind::Identifier);
 
-            const std::string name = peek().getValue();
-            consume(TokenType::Identifier);
+            const Token name = peek();
+            consume(TokenKind::Identifier);
 
-            parameters.emplace_back(FunctionDeclaration::Parameter{type, name});
+            m_parameterStack.emplace_back(type, spellingOf(name), name.getSymbol());
 
-            if (match(TokenType::Symbol, ",")) {
+            if (match(TokenKind::Comma)) {
                 advance(); // consume ","
             }
         }
-        consume(TokenType::Symbol, ")");
-        consume(TokenType::Symbol, "->");
-        returnType = peek().getValue();
-        consume(TokenType::Identifier);
+        consume(TokenKind::RightParen);
+        consume(TokenKind::Arrow);
+        returnType = spellingOf(peek());
+        consume(TokenKind::Identifier);
     }
 
-    if (match(TokenType::Keyword, "func")) {
+    if (match(TokenKind::Func)) {
         advance(); // consume "func" keyword
     }
     // from here it's
     // name { ... }
-    std::string name = peek().getValue();
-    consume(TokenType::Identifier);
-    consume(TokenType::Symbol, "{");
-
-    // parse body
-    std::unique_ptr<Block> body = std::make_unique<Block>();
-    while (!match(TokenType::Symbol, "}")) {
-        body->statements.push_back(parseStatement());
+    const Token name = peek();
+    consume(TokenKind::Identifier);
+
+    // parameters can't nest, so they are taken off the stack before the body
+    const std::span parameters =
+        m_arena->copyArray(std::span<const FunctionDeclaration::Parameter>(m_parameterStack));
+    m_parameterStack.clear();
+    if (m_panic != nullptr) {
+        return nullptr;
     }
 
-    consume(TokenType::Symbol, "}");
+    // parse body
+    Block *body = parseBlock();
 
-    return std::make_unique<FunctionDeclaration>(name, parameters, std::move(body), returnType);
+    return m_arena->create<FunctionDeclaration>(spellingOf(name), name.getSymbol(), parameters, body, returnType);
 }
 
-auto Parser::parseStatement() -> std::unique_ptr<AbstractNode> {
+auto Parser::parseStatement() -> AbstractNode * {
     // parse statement, which could be
     // - Variable declaration (type identifier)
     // - Assignment (identifier = expression)
     // - Function call (identifier (arguments))
     // - Return statement (return expression)
-    // - If statement (if condition { ... } else { ... })
-    // - While loop (while condition { ... })
     // - Binary operation (expression operator expression)
     // ? Expression statement (expression)
     // ? Block ( { ... } )
-    // the rest are handled by the respective functions
+    // the rest are handled by the respective functions, if statements and while loops are opened by parseBlock
 
-    if (match(TokenType::Keyword, "return")) {
+    if (match(TokenKind::Return)) {
         return parseReturnStatement();
     }
-    if (match(TokenType::Keyword, "if")) {
-        return parseIfStatement();
-    }
-    if (match(TokenType::Keyword, "while")) {
-        return parseWhileLoop();
-    }
     // identifier( ... )
-    if (match(TokenType::Identifier) && peekNext().getValue() == "(") {
-        std::unique_ptr<AbstractNode> node = parseFunctionCallExpr();
-        consume(TokenType::Symbol, ";");
+    if (match(TokenKind::Identifier) && peekNext().getKind() == TokenKind::LeftParen) {
+        AbstractNode *node = parseFunctionCallExpr();
+        consume(TokenKind::Semicolon);
         return node;
     }
     // [*]identifier = expression;
-    if (match(TokenType::Identifier) && peekNext().getValue() == "=" ||
-        match(TokenType::Symbol, "*") && peekNext().getType() == TokenType::Identifier) {
+    if ((match(TokenKind::Identifier) && peekNext().getKind() == TokenKind::Equal) ||
+        (match(TokenKind::Star) && peekNext().getKind() == TokenKind::Identifier)) {
         return parseAssignment();
     }
     // type [*|&] identifier [= expression];
-    if (match(TokenType::Identifier)) {
+    if (match(TokenKind::Identifier)) {
         return parseVariableDeclaration();
     }
 
-    throwError("Parser: invalid statement");
+    return reportError("Parser: invalid statement");
 }
 
-auto Parser::parseVariableDeclaration() -> std::unique_ptr<VariableDeclaration> {
+auto Parser::parseVariableDeclaration() -> VariableDeclaration * {
     // type [*|&] identifier [= expression];
 
-    std::string type = peek().getValue();
-    consume(TokenType::Identifier);
+    const std::string_view type = spellingOf(peek());
+    consume(TokenKind::Identifier);
 
     bool isPointer = false;
     bool isReference = false;
 
-    if (match(TokenType::Symbol, "*")) {
+    if (match(TokenKind::Star)) {
         isPointer = true;
         advance(); // Consume the '*'
-    } else if (match(TokenType::Symbol, "&")) {
+    } else if (match(TokenKind::Amp)) {
         isReference = true;
         advance(); // Consume the '&'
     }
 
-    std::string name = peek().getValue();
-    consume(TokenType::Identifier);
+    const Token name = peek();
+    consume(TokenKind::Identifier);
 
-    std::unique_ptr<AbstractNode> initializer = nullptr;
-    if (match(TokenType::Symbol, "=")) {
+    AbstractNode *initializer = nullptr;
+    if (match(TokenKind::Equal)) {
         advance(); // Consume the '='
         initializer = parseExpression();
     }
 
-    consume(TokenType::Symbol, ";");
+    consume(TokenKind::Semicolon);
 
-    return std::make_unique<VariableDeclaration>(type, name, isPointer, isReference, std::move(initializer));
+    return m_arena->create<VariableDeclaration>(type, spellingOf(name), name.getSymbol(), isPointer, isReference,
+                                                initializer);
 }
 
-auto Parser::parseAssignment() -> std::unique_ptr<Assignment> {
+auto Parser::parseAssignment() -> Assignment * {
     // [*]identifier = expression;
 
     bool isPointerDereference = false;
-    if (match(TokenType::Symbol, "*")) {
+    if (match(TokenKind::Star)) {
         advance(); // Consume the '*'
         isPointerDereference = true;
     }
 
-    std::string variable = peek().getValue();
-    consume(TokenType::Identifier);
-    consume(TokenType::Symbol, "=");
+    const Token variable = peek();
+    consume(TokenKind::Identifier);
+    consume(TokenKind::Equal);
 
-    auto value = parseExpression();
+    AbstractNode *value = parseExpression();
 
-    consume(TokenType::Symbol, ";");
+    consume(TokenKind::Semicolon);
 
-    return std::make_unique<Assignment>(variable, std::move(value), isPointerDereference);
+    return m_arena->create<Assignment>(spellingOf(variable), variable.getSymbol(), value, isPointerDereference);
 }
 
-auto Parser::parseFunctionCallExpr() -> std::unique_ptr<FunctionCall> {
+auto Parser::parseFunctionCallExpr() -> FunctionCall * {
     // identifier([argument, ...])
 
-    std::string functionName = peek().getValue();
-    consume(TokenType::Identifier);
-    consume(TokenType::Symbol, "(");
+    const Token functionName = peek();
+    consume(TokenKind::Identifier);
+    consume(TokenKind::LeftParen);
 
-    std::vector<std::unique_ptr<AbstractNode>> arguments;
-    if (!match(TokenType::Symbol, ")")) {
+    const std::size_t mark = m_nodeStack.size();
+    if (!match(TokenKind::RightParen)) {
         while (true) {
             // argument right now is just a variable declaration with no initial value
-            arguments.push_back(parseExpression());
-            if (match(TokenType::Symbol, ",")) {
+            AbstractNode *argument = parseExpression();
+            m_nodeStack.push_back(argument);
+            if (match(TokenKind::Comma) && m_panic == nullptr) {
                 advance(); // Consume ","
             } else {
                 break;
@@ -215,156 +540,311 @@ auto Parser::parseFunctionCallExpr() -> std::unique_ptr<FunctionCall> {
         }
     }
 
-    consume(TokenType::Symbol, ")");
+    const std::span arguments = popNodes(mark);
 
-    return std::make_unique<FunctionCall>(functionName, std::move(arguments));
-}
+    consume(TokenKind::RightParen);
 
-auto Parser::parseIfStatement() -> std::unique_ptr<IfStatement> {
-    // if condition { ... } else { ... }
+    return m_arena->create<FunctionCall>(spellingOf(functionName), functionName.getSymbol(), arguments);
+}
 
-    consume(TokenType::Keyword, "if");
+auto Parser::parseBlock() -> Block * {
+    // { ... }
+    // The blocks of nested if and while statements are kept on m_blockStack: opening one pushes it, and at its '}'
+    // the statement it belongs to is finished and added to the enclosing block
 
-    auto condition = parseExpression();
+    if (!consume(TokenKind::LeftBrace)) {
+        return nullptr;
+    }
 
-    auto thenBranch = parseBlock();
+    const std::size_t base = m_blockStack.size();
+    m_blockStack.push_back({OpenBlock::Kind::Body, m_nodeStack.size()});
+    while (true) {
+        // 'func' can't start a statement, the block is missing its '}' if one follows
+        if (!match(TokenKind::RightBrace) && !match(TokenKind::Func) && !isAtEnd()) {
+            if (match(TokenKind::If) || match(TokenKind::While)) {
+                openBlockStatement();
+            } else {
+                addStatement(parseStatement());
+            }
+            continue;
+        }
 
-    if (match(TokenType::Keyword, "else")) {
-        advance(); // Consume "else"
-        auto elseBranch = parseBlock();
-        return std::make_unique<IfStatement>(std::move(condition), std::move(thenBranch), std::move(elseBranch));
+        Block *block = m_arena->create<Block>(popNodes(m_blockStack.back().mark));
+        consume(TokenKind::RightBrace);
+        if (m_blockStack.size() == base + 1) {
+            m_blockStack.pop_back();
+            return block;
+        }
+        closeBlock(block);
     }
-
-    return std::make_unique<IfStatement>(std::move(condition), std::move(thenBranch));
 }
 
-auto Parser::parseWhileLoop() -> std::unique_ptr<WhileLoop> {
+void Parser::openBlockStatement() {
+    // if condition { ... } [else { ... }]
     // while condition { ... }
 
-    consume(TokenType::Keyword, "while");
-
-    auto condition = parseExpression();
-
-    auto body = parseBlock();
+    const bool isLoop = match(TokenKind::While);
+    advance(); // Consume "if" or "while"
 
-    return std::make_unique<WhileLoop>(std::move(condition), std::move(body));
+    AbstractNode *condition = parseExpression();
+    if (m_panic != nullptr || !consume(TokenKind::LeftBrace)) {
+        addStatement(nullptr);
+        return;
+    }
+    m_blockStack.push_back({isLoop ? OpenBlock::Kind::Loop : OpenBlock::Kind::Then, m_nodeStack.size(), condition});
 }
 
-auto Parser::parseBlock() -> std::unique_ptr<Block> {
-    // { ... }
-
-    auto block = std::make_unique<Block>();
-
-    consume(TokenType::Symbol, "{");
-
-    while (!match(TokenType::Symbol, "}")) {
-        block->statements.push_back(parseStatement());
+void Parser::closeBlock(Block *block) {
+    const OpenBlock open = m_blockStack.back();
+    m_blockStack.pop_back();
+
+    switch (open.kind) {
+        case OpenBlock::Kind::Then:
+            if (match(TokenKind::Else)) {
+                advance(); // Consume "else"
+                if (!consume(TokenKind::LeftBrace)) {
+                    addStatement(nullptr);
+                    return;
+                }
+                m_blockStack.push_back({OpenBlock::Kind::Else, m_nodeStack.size(), open.condition, block});
+                return;
+            }
+            addStatement(m_arena->create<IfStatement>(open.condition, block));
+            return;
+        case OpenBlock::Kind::Else:
+            addStatement(m_arena->create<IfStatement>(open.condition, open.thenBranch, block));
+            return;
+        case OpenBlock::Kind::Loop:
+            addStatement(m_arena->create<WhileLoop>(open.condition, block));
+            return;
+        case OpenBlock::Kind::Body:
+            break;
     }
+}
 
-    consume(TokenType::Symbol, "}");
-
-    return block;
+void Parser::addStatement(AbstractNode *statement) {
+    if (m_panic != nullptr) {
+        statement = m_panic;
+        synchronizeStatement();
+    }
+    m_nodeStack.push_back(statement);
 }
 
-auto Parser::parseReturnStatement() -> std::unique_ptr<ReturnStatement> {
+auto Parser::parseReturnStatement() -> ReturnStatement * {
     // return [expression];
 
-    consume(TokenType::Keyword, "return");
+    consume(TokenKind::Return);
 
-    std::unique_ptr<AbstractNode> value;
-    if (!match(TokenType::Symbol, ";")) {
+    AbstractNode *value;
+    if (!match(TokenKind::Semicolon)) {
         value = parseExpression();
     } else {
         value = nullptr;
         printf("return statement without expression\n");
     }
-    consume(TokenType::Symbol, ";");
-
-    return std::make_unique<ReturnStatement>(std::move(value));
-}
+    consume(TokenKind::Semicolon);
 
-auto Parser::parseExpression() -> std::unique_ptr<AbstractNode> {
-    // Parse an expression by parsing a binary operation, which will recursively parse the expression
-    return parseBinaryOperation();
+    return m_arena->create<ReturnStatement>(value);
 }
 
-auto Parser::parseBinaryOperation(const int precedence) -> std::unique_ptr<AbstractNode> {
-    // Parse binary operations with precedence
-    // - Parse left-hand side
-    // - Parse operator
-    // - Parse right-hand side
-
-    auto lhs = parseUnaryExpression();
-
-    while (true) {
-        if (!isBinaryOperator(peek()))
-            break;
-
-        const int currentPrecedence = getOperatorPrecedence(peek().getValue());
-        if (currentPrecedence < precedence)
-            break;
-
-        std::string op = peek().getValue();
-        consume(TokenType::Symbol); // Consume the operator
-
-        auto rhs = parseBinaryOperation(currentPrecedence + 1);
+auto Parser::parseExpression() -> AbstractNode * {
+    // Pratt parser on an explicit stack. Prefix operators and parentheses are opened on m_expressionStack until an
+    // operand is found. Operators then keep extending the operand as long as they bind tighter than the construct it
+    // is part of, an infix operator or the argument list of a call is opened in turn and wants the next operand.
+    // Otherwise the operand is complete and closes the innermost open construct, which becomes the operand.
 
-        lhs = std::make_unique<BinaryOperation>(std::move(lhs), op, std::move(rhs));
+    // nothing is consumed while panicking, a statement that failed before its expression is skipped as a whole
+    if (m_panic != nullptr) {
+        return m_panic;
     }
 
-    return lhs;
-}
+    const std::size_t base = m_expressionStack.size();
+    std::uint8_t      minimumPower = 0;
+    while (true) {
+        AbstractNode *operand = nullptr;
+        while (operand == nullptr) {
+            const TokenKind kind = peek().getKind();
+            if (const BindingPower &power = bindingPowerOf(kind); power.prefix != 0) {
+                // -expr, !expr
+                m_expressionStack.push_back({OpenExpression::Kind::Prefix, minimumPower, power.prefixOperator});
+                advance();                   // Consume the operator
+                minimumPower = power.prefix; // Only operators binding tighter than the prefix join it
+            } else if (kind == TokenKind::LeftParen) {
+                // (expression)
+                m_expressionStack.push_back({OpenExpression::Kind::Group, minimumPower});
+                advance(); // Consume "("
+                minimumPower = 0;
+            } else {
+                operand = parsePrimaryExpression();
+            }
+        }
 
-auto Parser::parseUnaryExpression() -> std::unique_ptr<AbstractNode> {
-    // Parse unary expressions, which can be
-    // - -expr
-    // - !expr
+        bool expectOperand = false;
+        while (!expectOperand) {
+            if (m_panic == nullptr) {
+                const BindingPower &power = bindingPowerOf(peek().getKind());
+                if (power.postfix != 0 && power.postfix >= minimumPower) {
+                    // callee([argument, ...]), functions are only called by name
+                    if (operand->getKind() != NodeKind::Reference || static_cast<Reference *>(operand)->isReference) {
+                        operand = reportError("only named functions can be called");
+                        continue;
+                    }
+                    // the callee was created just before, the call replaces it in the arena statistics
+                    const Reference &callee = *static_cast<Reference *>(operand);
+                    m_arena->discard(callee);
+                    advance(); // Consume "("
+                    if (match(TokenKind::RightParen)) {
+                        advance(); // Consume ")"
+                        operand = m_arena->create<FunctionCall>(callee.name, callee.symbol,
+                                                                std::span<AbstractNode *>());
+                        continue;
+                    }
+                    m_expressionStack.push_back({OpenExpression::Kind::Call, minimumPower, {}, nullptr, callee.name,
+                                                 callee.symbol, m_nodeStack.size()});
+                    minimumPower = 0;
+                    break;
+                }
+                if (power.infixLeft != 0 && power.infixLeft >= minimumPower) {
+                    m_expressionStack.push_back(
+                            {OpenExpression::Kind::Binary, minimumPower, power.infixOperator, operand});
+                    advance(); // Consume the operator
+                    minimumPower = power.infixRight;
+                    break;
+                }
+            }
 
-    if (match(TokenType::Symbol, "-") || match(TokenType::Symbol, "!")) {
-        std::string op = peek().getValue();
-        advance();                             // Consume the operator
-        auto operand = parseUnaryExpression(); // Recursively parse the operand
-        return std::make_unique<UnaryOperation>(std::move(operand), op);
+            if (m_expressionStack.size() == base) {
+                return operand;
+            }
+            const OpenExpression open = m_expressionStack.back();
+            m_expressionStack.pop_back();
+            minimumPower = open.minimumPower;
+
+            switch (open.kind) {
+                case OpenExpression::Kind::Prefix:
+                    operand = m_arena->create<UnaryOperation>(operand, open.operatorKind);
+                    break;
+                case OpenExpression::Kind::Binary:
+                    operand = m_arena->create<BinaryOperation>(open.left, open.operatorKind, operand);
+                    break;
+                case OpenExpression::Kind::Group:
+                    consume(TokenKind::RightParen);
+                    break;
+                case OpenExpression::Kind::Call:
+                    m_nodeStack.push_back(operand);
+                    if (match(TokenKind::Comma) && m_panic == nullptr) {
+                        advance(); // Consume ","
+                        m_expressionStack.push_back(open);
+                        minimumPower = 0;
+                        expectOperand = true;
+                        break;
+                    }
+                    const std::span arguments = popNodes(open.mark);
+                    consume(TokenKind::RightParen);
+                    operand = m_arena->create<FunctionCall>(open.name, open.symbol, arguments);
+                    break;
+            }
+        }
     }
-    return parsePrimaryExpression(); // If no unary operator, parse a primary expression
 }
 
-auto Parser::parsePrimaryExpression() -> std::unique_ptr<AbstractNode> {
-    // Parse primary expressions, which can be
+auto Parser::parsePrimaryExpression() -> AbstractNode * {
+    // Parse the operands that don't contain an expression, which can be
     // - Literal (integer, float, char, string)
-    // - Reference ([&]identifier)
-    // - Function call (identifier ([arguments]))
-    // - Parenthesized expression ((expression))
+    // - Reference ([&]identifier), also the callee of a call
+    // Parenthesized expressions and the arguments of calls are opened by parseExpression
 
-    if (match(TokenType::Integer) || match(TokenType::Float) || match(TokenType::Char) || match(TokenType::String)) {
-        auto value = peek().getValue();
-        auto type = tokenTypeToString(peek().getType());
+    if (match(TokenKind::Integer) || match(TokenKind::Float) || match(TokenKind::Char) || match(TokenKind::String)) {
+        const Token literal = peek();
         advance();
-        return std::make_unique<Literal>(value, type);
+
+        // numbers carry the value the lexer converted, the spelling is kept for printing
+        const std::string_view value = m_arena->copyString(literal.getValue());
+        switch (literal.getKind()) {
+            case TokenKind::Integer:
+                return m_arena->create<Literal>(LiteralKind::Integer, value, literal.getNumber());
+            case TokenKind::Float:
+                return m_arena->create<Literal>(LiteralKind::Float, value, literal.getNumber());
+            case TokenKind::Char:
+                return m_arena->create<Literal>(LiteralKind::Char, value);
+            default:
+                return m_arena->create<Literal>(LiteralKind::String, value);
+        }
     }
 
-    if (match(TokenType::Identifier)) {
+    if (match(TokenKind::Identifier)) {
         bool isReference = false;
-        if (peek().getValue() == "&") {
+        if (match(TokenKind::Amp)) {
             advance();
             isReference = true;
         }
 
-        std::string name = peek().getValue();
-        if (peekNext().getValue() == "(") {
-            return parseFunctionCallExpr(); // Handle function call
+        const Token name = peek();
+        consume(TokenKind::Identifier);
+
+        return m_arena->create<Reference>(spellingOf(name), name.getSymbol(), isReference); // Variable reference
+    }
+
+    return reportError("Unexpected primary expression.");
+}
+
+auto Parser::startsDeclaration() const -> bool {
+    // - (             # params and return type explicitly defined
+    // - func          # params and return type inferred (void)
+    // - identifier {  # params and return type inferred (void)
+    return match(TokenKind::LeftParen) || match(TokenKind::Func) ||
+           (match(TokenKind::Identifier) && peekNext().getKind() == TokenKind::LeftBrace);
+}
+
+void Parser::synchronizeStatement() {
+    std::size_t depth = 0;
+    while (!isAtEnd()) {
+        const TokenKind kind = peek().getKind();
+        if (depth == 0 && (kind == TokenKind::RightBrace || kind == TokenKind::Func)) {
+            break;
+        }
+        advance();
+        if (kind == TokenKind::LeftBrace) {
+            depth++;
+        } else if ((kind == TokenKind::RightBrace && --depth == 0) || (kind == TokenKind::Semicolon && depth == 0)) {
+            break;
         }
-        consume(TokenType::Identifier);
+    }
+    m_panic = nullptr;
+}
 
-        return std::make_unique<Reference>(name, isReference); // Variable reference
+void Parser::synchronizeDeclaration(bool skipFirst) {
+    std::size_t depth = 0;
+    while (!isAtEnd()) {
+        if (depth == 0 && !skipFirst && startsDeclaration()) {
+            break;
+        }
+        const TokenKind kind = peek().getKind();
+        advance();
+        skipFirst = false;
+        if (kind == TokenKind::LeftBrace) {
+            depth++;
+        } else if (kind == TokenKind::RightBrace && depth > 0 && --depth == 0) {
+            break;
+        }
     }
+    m_panic = nullptr;
+}
 
-    if (match(TokenType::Symbol, "(")) {
-        advance(); // Consume "("
-        auto expr = parseExpression();
-        consume(TokenType::Symbol, ")");
-        return expr; // Parenthesized expression
+auto Parser::reportError(const std::string_view message) -> ErrorNode * {
+    if (m_diagnostics == nullptr) {
+        throwError(std::string(message));
     }
+    // errors until the parser has synchronized are most likely caused by the first one
+    if (m_panic == nullptr) {
+        const Token &token = peek();
+        m_diagnostics->error({token.getOffset(), static_cast<std::uint32_t>(token.getValue().size())}, message);
+        m_errorCount++;
+        m_panic = m_arena->create<ErrorNode>(token.getOffset(), message);
+    }
+    return m_panic;
+}
 
-    throwError("Unexpected primary expression.");
+auto Parser::expectedMessage(const TokenKind kind) -> std::string_view {
+    return EXPECTED_MESSAGES[static_cast<std::size_t>(kind)];
 }
@@ -0,0 +1,135 @@
+#include "../include/Resolver.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/RecursiveVisitor.h"
+
+// Keeps the innermost declaration of every name in a table indexed by SymbolId, so a lookup is one array access.
+// Declaring a name records the binding it replaces, leaving a scope restores the bindings replaced in it.
+class Resolver::Builder : public RecursiveVisitor<Builder> {
+public:
+    Resolution resolution;
+
+    auto visitProgram(Program &node) -> bool;
+    auto visitBlock(Block &node) -> bool;
+    auto visitFunctionDeclaration(FunctionDeclaration &node) -> bool;
+    void leaveProgram(Program &node);
+    void leaveBlock(Block &node);
+    void leaveFunctionDeclaration(FunctionDeclaration &node);
+    void leaveVariableDeclaration(VariableDeclaration &node);
+    void leaveFunctionCall(FunctionCall &node);
+    void leaveReference(Reference &node);
+    void leaveAssignment(Assignment &node);
+
+private:
+    // Innermost declarations of a name, variables and functions are separate namespaces
+    struct Binding {
+        DeclarationSlot variable = INVALID_SLOT;
+        DeclarationSlot function = INVALID_SLOT;
+    };
+
+    // Binding of a name before a declaration in an open scope replaced it
+    struct Shadowed {
+        SymbolId symbol;
+        Binding  binding;
+    };
+
+    std::vector<Binding>     m_bindings; // indexed by SymbolId
+    std::vector<Shadowed>    m_shadowed;
+    std::vector<std::size_t> m_scopes; // size of m_shadowed when each open scope was entered
+
+    void enterScope();
+    void leaveScope();
+
+    // Hands out the next slot of a namespace and binds symbol to it, names without a symbol can't be referred to
+    auto declare(SymbolId symbol, DeclarationSlot Binding::*space, std::uint32_t &count) -> DeclarationSlot;
+
+    // Innermost declaration of symbol in a namespace, INVALID_SLOT if there is none
+    [[nodiscard]] auto lookup(SymbolId symbol, DeclarationSlot Binding::*space) const -> DeclarationSlot;
+
+    auto lookupVariable(SymbolId symbol, std::string_view name) const -> DeclarationSlot;
+};
+
+auto Resolver::resolve(Program &program) -> Resolution {
+    Builder builder;
+    builder.traverse(program);
+    return builder.resolution;
+}
+
+auto Resolver::Builder::visitProgram(Program &) -> bool {
+    enterScope();
+    return true;
+}
+
+auto Resolver::Builder::visitBlock(Block &) -> bool {
+    enterScope();
+    return true;
+}
+
+auto Resolver::Builder::visitFunctionDeclaration(FunctionDeclaration &node) -> bool {
+    // declared before its body, so it can call itself
+    node.slot = declare(node.symbol, &Binding::function, resolution.functionCount);
+
+    enterScope();
+    for (FunctionDeclaration::Parameter &parameter : node.parameters) {
+        parameter.slot = declare(parameter.symbol, &Binding::variable, resolution.variableCount);
+    }
+    return true;
+}
+
+void Resolver::Builder::leaveProgram(Program &) { leaveScope(); }
+
+void Resolver::Builder::leaveBlock(Block &) { leaveScope(); }
+
+void Resolver::Builder::leaveFunctionDeclaration(FunctionDeclaration &) { leaveScope(); }
+
+void Resolver::Builder::leaveVariableDeclaration(VariableDeclaration &node) {
+    // declared after its initializer, which still sees the declarations outside
+    node.slot = declare(node.symbol, &Binding::variable, resolution.variableCount);
+}
+
+void Resolver::Builder::leaveFunctionCall(FunctionCall &node) { node.slot = lookup(node.symbol, &Binding::function); }
+
+void Resolver::Builder::leaveReference(Reference &node) { node.slot = lookupVariable(node.symbol, node.name); }
+
+void Resolver::Builder::leaveAssignment(Assignment &node) { node.slot = lookupVariable(node.symbol, node.name); }
+
+void Resolver::Builder::enterScope() { m_scopes.push_back(m_shadowed.size()); }
+
+void Resolver::Builder::leaveScope() {
+    const std::size_t base = m_scopes.back();
+    m_scopes.pop_back();
+    while (m_shadowed.size() > base) {
+        m_bindings[m_shadowed.back().symbol] = m_shadowed.back().binding;
+        m_shadowed.pop_back();
+    }
+}
+
+auto Resolver::Builder::declare(const SymbolId symbol, DeclarationSlot Binding::*const space, std::uint32_t &count)
+        -> DeclarationSlot {
+    const DeclarationSlot slot = count++;
+    if (symbol == INVALID_SYMBOL) {
+        return slot;
+    }
+    if (symbol >= m_bindings.size()) {
+        m_bindings.resize(symbol + 1);
+    }
+    m_shadowed.push_back({symbol, m_bindings[symbol]});
+    m_bindings[symbol].*space = slot;
+    return slot;
+}
+
+auto Resolver::Builder::lookup(const SymbolId symbol, DeclarationSlot Binding::*const space) const
+        -> DeclarationSlot {
+    return symbol < m_bindings.size() ? m_bindings[symbol].*space : INVALID_SLOT;
+}
+
+auto Resolver::Builder::lookupVariable(const SymbolId symbol, const std::string_view name) const -> DeclarationSlot {
+    const DeclarationSlot slot = lookup(symbol, &Binding::variable);
+    if (slot == INVALID_SLOT) {
+        throw std::runtime_error("Unknown variable name: " + std::string(name));
+    }
+    return slot;
+}
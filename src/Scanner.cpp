@@ -0,0 +1,146 @@
+#include "../include/Scanner.h"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PCORE_SCANNER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PCORE_SCANNER_SSE2 1
+#endif
+
+namespace {
+    constexpr auto isWhitespace(const char c) -> bool {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\0';
+    }
+
+    constexpr auto isIdentifierChar(const char c) -> bool {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+#if defined(PCORE_SCANNER_AVX2)
+    using Vector = __m256i;
+    using Mask = std::uint32_t;
+
+    constexpr std::size_t VECTOR_SIZE = 32;
+
+    auto load(const char *data) -> Vector { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data)); }
+    auto splat(const char c) -> Vector { return _mm256_set1_epi8(c); }
+    auto equal(const Vector a, const Vector b) -> Vector { return _mm256_cmpeq_epi8(a, b); }
+    auto greater(const Vector a, const Vector b) -> Vector { return _mm256_cmpgt_epi8(a, b); }
+    auto both(const Vector a, const Vector b) -> Vector { return _mm256_and_si256(a, b); }
+    auto either(const Vector a, const Vector b) -> Vector { return _mm256_or_si256(a, b); }
+    auto toMask(const Vector v) -> Mask { return static_cast<Mask>(_mm256_movemask_epi8(v)); }
+#elif defined(PCORE_SCANNER_SSE2)
+    using Vector = __m128i;
+    using Mask = std::uint32_t;
+
+    constexpr std::size_t VECTOR_SIZE = 16;
+
+    auto load(const char *data) -> Vector { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)); }
+    auto splat(const char c) -> Vector { return _mm_set1_epi8(c); }
+    auto equal(const Vector a, const Vector b) -> Vector { return _mm_cmpeq_epi8(a, b); }
+    auto greater(const Vector a, const Vector b) -> Vector { return _mm_cmpgt_epi8(a, b); }
+    auto both(const Vector a, const Vector b) -> Vector { return _mm_and_si128(a, b); }
+    auto either(const Vector a, const Vector b) -> Vector { return _mm_or_si128(a, b); }
+    auto toMask(const Vector v) -> Mask { return static_cast<Mask>(_mm_movemask_epi8(v)); }
+#endif
+
+#if defined(PCORE_SCANNER_AVX2) || defined(PCORE_SCANNER_SSE2)
+    constexpr Mask FULL_MASK = VECTOR_SIZE == 32 ? ~Mask{0} : (Mask{1} << VECTOR_SIZE) - 1;
+
+    // Signed byte range check lo <= c <= hi, bytes >= 0x80 are negative and never inside an ASCII range
+    auto inRange(const Vector bytes, const char lo, const char hi) -> Vector {
+        return both(greater(bytes, splat(static_cast<char>(lo - 1))), greater(splat(static_cast<char>(hi + 1)), bytes));
+    }
+
+    // Mask of the bytes that are whitespace
+    auto whitespaceMask(const Vector bytes) -> Mask {
+        const Vector spaces = either(equal(bytes, splat(' ')), equal(bytes, splat('\t')));
+        const Vector breaks = either(equal(bytes, splat('\n')), equal(bytes, splat('\r')));
+        return toMask(either(either(spaces, breaks), equal(bytes, splat('\0'))));
+    }
+
+    // Mask of the bytes that can continue an identifier
+    auto identifierMask(const Vector bytes) -> Mask {
+        const Vector letters = either(inRange(bytes, 'a', 'z'), inRange(bytes, 'A', 'Z'));
+        const Vector digits = inRange(bytes, '0', '9');
+        return toMask(either(either(letters, digits), equal(bytes, splat('_'))));
+    }
+
+    // Advances vector by vector while every byte matches, the returned pointer is within VECTOR_SIZE of the stop
+    template <typename MaskFunction>
+    auto skipWhile(const char *current, const char *end, MaskFunction &&matching) -> const char * {
+        while (static_cast<std::size_t>(end - current) >= VECTOR_SIZE) {
+            if (const Mask mismatches = ~matching(load(current)) & FULL_MASK; mismatches != 0) {
+                return current + std::countr_zero(mismatches);
+            }
+            current += VECTOR_SIZE;
+        }
+        return current;
+    }
+#endif
+} // namespace
+
+namespace scanner {
+    auto skipWhitespace(const char *begin, const char *end) -> const char * {
+        const char *current = begin;
+#if defined(PCORE_SCANNER_AVX2) || defined(PCORE_SCANNER_SSE2)
+        current = skipWhile(current, end, whitespaceMask);
+#endif
+        while (current < end && isWhitespace(*current)) {
+            ++current;
+        }
+        return current;
+    }
+
+    auto findLineEnd(const char *begin, const char *end) -> const char * {
+        const char *current = begin;
+#if defined(PCORE_SCANNER_AVX2) || defined(PCORE_SCANNER_SSE2)
+        const Vector newline = splat('\n');
+        current = skipWhile(current, end, [&](const Vector bytes) { return ~toMask(equal(bytes, newline)); });
+#endif
+        while (current < end && *current != '\n') {
+            ++current;
+        }
+        return current;
+    }
+
+    auto skipIdentifier(const char *begin, const char *end) -> const char * {
+        const char *current = begin;
+#if defined(PCORE_SCANNER_AVX2) || defined(PCORE_SCANNER_SSE2)
+        current = skipWhile(current, end, identifierMask);
+#endif
+        while (current < end && isIdentifierChar(*current)) {
+            ++current;
+        }
+        return current;
+    }
+
+    auto countNewlines(const char *begin, const char *end) -> std::size_t {
+        std::size_t count = 0;
+        const char *current = begin;
+#if defined(PCORE_SCANNER_AVX2) || defined(PCORE_SCANNER_SSE2)
+        const Vector newline = splat('\n');
+        for (; static_cast<std::size_t>(end - current) >= VECTOR_SIZE; current += VECTOR_SIZE) {
+            count += std::popcount(toMask(equal(load(current), newline)));
+        }
+#endif
+        for (; current < end; ++current) {
+            count += *current == '\n' ? 1 : 0;
+        }
+        return count;
+    }
+
+    auto instructionSet() -> const char * {
+#if defined(PCORE_SCANNER_AVX2)
+        return "AVX2";
+#elif defined(PCORE_SCANNER_SSE2)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+} // namespace scanner
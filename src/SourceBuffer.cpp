@@ -0,0 +1,49 @@
+#include "../include/SourceBuffer.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "../include/Scanner.h"
+
+SourceBuffer::SourceBuffer(std::unique_ptr<llvm::MemoryBuffer> buffer) :
+    m_buffer(std::move(buffer)), m_lineIndex(std::make_unique<LineIndex>()) {
+    if (m_buffer->getBufferSize() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Source " + m_buffer->getBufferIdentifier().str() + " exceeds 4 GiB");
+    }
+}
+
+auto SourceBuffer::fromFile(const std::string &filepath) -> SourceBuffer {
+    auto buffer = llvm::MemoryBuffer::getFile(filepath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        throw std::runtime_error("Failed to open file " + filepath + ": " + buffer.getError().message());
+    }
+    return SourceBuffer(std::move(*buffer));
+}
+
+auto SourceBuffer::fromMemory(const std::string_view text, const std::string &name) -> SourceBuffer {
+    return SourceBuffer(llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(text.data(), text.size()), name,
+                                                         /*RequiresNullTerminator=*/false));
+}
+
+auto SourceBuffer::getPosition(const std::uint32_t offset) const -> Position {
+    std::call_once(m_lineIndex->built, [this] {
+        const char *begin = m_buffer->getBufferStart();
+        const char *end = m_buffer->getBufferEnd();
+
+        std::vector<std::uint32_t> &lineStarts = m_lineIndex->lineStarts;
+        lineStarts.reserve(scanner::countNewlines(begin, end) + 1);
+        lineStarts.push_back(0);
+        for (const char *newline = scanner::findLineEnd(begin, end); newline != end;
+             newline = scanner::findLineEnd(newline + 1, end)) {
+            lineStarts.push_back(static_cast<std::uint32_t>(newline + 1 - begin));
+        }
+    });
+
+    // the line is the last line start at or before the offset
+    const std::vector<std::uint32_t> &lineStarts = m_lineIndex->lineStarts;
+    const auto line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - 1;
+    return {static_cast<unsigned int>(line - lineStarts.begin() + 1), offset - *line + 1};
+}
+
+Position::Position(const unsigned int line, const unsigned int column) : m_line(line), m_column(column) {}
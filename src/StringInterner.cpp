@@ -0,0 +1,17 @@
+#include "../include/StringInterner.h"
+
+auto StringInterner::intern(const std::string_view spelling) -> SymbolId {
+    const auto [entry, inserted] =
+            m_ids.try_emplace(llvm::StringRef(spelling.data(), spelling.size()), static_cast<SymbolId>(size()));
+    if (inserted) {
+        // StringMap entries never move, so the key can be handed out as the spelling
+        const llvm::StringRef key = entry->getKey();
+        m_spellings.emplace_back(key.data(), key.size());
+    }
+    return entry->getValue();
+}
+
+auto StringInterner::find(const std::string_view spelling) const -> SymbolId {
+    const auto entry = m_ids.find(llvm::StringRef(spelling.data(), spelling.size()));
+    return entry == m_ids.end() ? INVALID_SYMBOL : entry->getValue();
+}
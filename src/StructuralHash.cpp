@@ -0,0 +1,276 @@
+#include "../include/StructuralHash.h"
+
+#include <bit>
+#include <llvm/Support/xxhash.h>
+
+#include "../include/RecursiveVisitor.h"
+
+namespace {
+    constexpr std::uint64_t LOW_SEED = 0x243F6A8885A308D3;
+    constexpr std::uint64_t HIGH_SEED = 0x13198A2E03707344;
+    constexpr std::uint64_t LOW_MULTIPLIER = 0x9E3779B97F4A7C15;
+    constexpr std::uint64_t HIGH_MULTIPLIER = 0xC2B2AE3D27D4EB4F;
+
+    // Avalanche of a 64-bit lane, the MurmurHash3 finalizer
+    auto mix(std::uint64_t value) -> std::uint64_t {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCD;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53;
+        value ^= value >> 33;
+        return value;
+    }
+} // namespace
+
+StructuralHashBuilder::StructuralHashBuilder(const NodeKind kind) : m_low(LOW_SEED), m_high(HIGH_SEED) {
+    add(static_cast<std::uint64_t>(kind));
+}
+
+void StructuralHashBuilder::add(const std::uint64_t word) {
+    m_low = std::rotl(m_low ^ (word * LOW_MULTIPLIER), 31) * HIGH_MULTIPLIER;
+    m_high = std::rotl(m_high ^ (word * HIGH_MULTIPLIER), 33) * LOW_MULTIPLIER + m_low;
+    m_count++;
+}
+
+void StructuralHashBuilder::add(const std::string_view text) {
+    add(text.size());
+    add(llvm::xxHash64(llvm::StringRef(text.data(), text.size())));
+}
+
+void StructuralHashBuilder::add(const StructuralHash &hash) {
+    add(hash.low);
+    add(hash.high);
+}
+
+auto StructuralHashBuilder::finish() const -> StructuralHash {
+    const std::uint64_t low = mix(m_low ^ m_count);
+    const std::uint64_t high = mix(m_high + low);
+    return {mix(low ^ high), high};
+}
+
+// Hashes a node once its children are hashed, the hashes of finished children wait on a stack until their parent
+// takes them. A node hashes its kind, its own fields, the number of its children and their hashes in order; optional
+// children are always the last ones, so the count also tells which of them are present. Expressions get a binding
+// hash next to the structural one, built the same way except that references and calls hash the declaration they
+// are bound to instead of the name.
+class StructuralHashes::Builder : public RecursiveVisitor<Builder> {
+public:
+    explicit Builder(StructuralHashes &hashes) : m_hashes(hashes) {}
+
+    void leaveProgram(Program &node);
+    void leaveBlock(Block &node);
+    void leaveFunctionDeclaration(FunctionDeclaration &node);
+    void leaveFunctionCall(FunctionCall &node);
+    void leaveVariableDeclaration(VariableDeclaration &node);
+    void leaveLiteral(Literal &node);
+    void leaveReference(Reference &node);
+    void leaveBinaryOperation(BinaryOperation &node);
+    void leaveUnaryOperation(UnaryOperation &node);
+    void leaveIfStatement(IfStatement &node);
+    void leaveWhileLoop(WhileLoop &node);
+    void leaveReturnStatement(ReturnStatement &node);
+    void leaveExpressionStatement(ExpressionStatement &node);
+    void leaveAssignment(Assignment &node);
+    void leaveError(ErrorNode &node);
+
+private:
+    StructuralHashes       &m_hashes;
+    std::vector<Expression> m_finished; // hashes of finished subtrees not yet taken by their parent, the binding
+                                        // hash equals the structural one outside of expressions
+
+    // Adds the hashes of the children of node and replaces them on the stack by the hash of node
+    template <typename Node>
+    auto finish(const Node &node, StructuralHashBuilder &hash) -> StructuralHash;
+
+    // finish for an expression, also folds the binding hashes of the children into binding and indexes the node
+    template <typename Node>
+    void finishExpression(const Node &node, StructuralHashBuilder &hash, StructuralHashBuilder &binding);
+};
+
+auto StructuralHashes::compute(const Program &program) -> StructuralHashes {
+    StructuralHashes hashes;
+
+    const AstStatistics statistics = program.getStatistics();
+    std::size_t         expressions = 0;
+    for (const NodeKind kind : {NodeKind::FunctionCall, NodeKind::Literal, NodeKind::Reference,
+                                NodeKind::BinaryOperation, NodeKind::UnaryOperation}) {
+        expressions += statistics.nodeCounts[static_cast<std::size_t>(kind)];
+    }
+    hashes.m_functions.reserve(statistics.nodeCounts[static_cast<std::size_t>(NodeKind::FunctionDeclaration)]);
+    hashes.m_expressions.reserve(expressions);
+    hashes.m_canonical.reserve(expressions);
+
+    // the visitor hands out mutable nodes, hashing doesn't modify them
+    Builder(hashes).traverse(const_cast<Program &>(program));
+    return hashes;
+}
+
+auto StructuralHashes::findExpressionHash(const AbstractNode &expression) const -> const StructuralHash * {
+    const auto entry = m_expressions.find(&expression);
+    return entry == m_expressions.end() ? nullptr : &entry->second.structure;
+}
+
+auto StructuralHashes::getCanonicalExpression(const AbstractNode &expression) const -> const AbstractNode * {
+    const auto entry = m_expressions.find(&expression);
+    return entry == m_expressions.end() ? nullptr : m_canonical.lookup(entry->second.binding);
+}
+
+template <typename Node>
+auto StructuralHashes::Builder::finish(const Node &node, StructuralHashBuilder &hash) -> StructuralHash {
+    std::size_t count = 0;
+    forEachChildOf(node, [&](AbstractNode *) { count++; });
+    hash.add(count);
+    for (std::size_t index = m_finished.size() - count; index < m_finished.size(); ++index) {
+        hash.add(m_finished[index].structure);
+    }
+
+    const StructuralHash result = hash.finish();
+    m_finished.resize(m_finished.size() - count);
+    m_finished.push_back({result, result});
+    return result;
+}
+
+template <typename Node>
+void StructuralHashes::Builder::finishExpression(const Node &node, StructuralHashBuilder &hash,
+                                                 StructuralHashBuilder &binding) {
+    std::size_t count = 0;
+    forEachChildOf(node, [&](AbstractNode *) { count++; });
+    hash.add(count);
+    binding.add(count);
+    for (std::size_t index = m_finished.size() - count; index < m_finished.size(); ++index) {
+        hash.add(m_finished[index].structure);
+        binding.add(m_finished[index].binding);
+    }
+
+    const Expression result{hash.finish(), binding.finish()};
+    m_finished.resize(m_finished.size() - count);
+    m_finished.push_back(result);
+    m_hashes.m_expressions.try_emplace(&node, result);
+    m_hashes.m_canonical.try_emplace(result.binding, &node);
+}
+
+void StructuralHashes::Builder::leaveProgram(Program &node) {
+    StructuralHashBuilder hash(Program::KIND);
+    hash.add(node.name);
+    m_hashes.m_program = finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveBlock(Block &node) {
+    StructuralHashBuilder hash(Block::KIND);
+    finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveFunctionDeclaration(FunctionDeclaration &node) {
+    // the body is the only child, so its hash is on top
+    const StructuralHash body = node.body == nullptr ? StructuralHash{} : m_finished.back().structure;
+
+    StructuralHashBuilder hash(FunctionDeclaration::KIND);
+    hash.add(node.name);
+    hash.add(node.returnType);
+    hash.add(node.parameters.size());
+    for (const FunctionDeclaration::Parameter &parameter : node.parameters) {
+        hash.add(parameter.type);
+        hash.add(parameter.name);
+    }
+    m_hashes.m_functions.push_back({&node, body, finish(node, hash)});
+}
+
+void StructuralHashes::Builder::leaveFunctionCall(FunctionCall &node) {
+    StructuralHashBuilder hash(FunctionCall::KIND);
+    hash.add(node.name);
+    // built-in functions aren't resolved, their name is what they are bound to
+    StructuralHashBuilder binding = hash;
+    binding.add(node.slot);
+    finishExpression(node, hash, binding);
+}
+
+void StructuralHashes::Builder::leaveVariableDeclaration(VariableDeclaration &node) {
+    StructuralHashBuilder hash(VariableDeclaration::KIND);
+    hash.add(node.type);
+    hash.add(node.name);
+    hash.add(static_cast<std::uint64_t>(node.isPointer) | static_cast<std::uint64_t>(node.isReference) << 1);
+    finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveLiteral(Literal &node) {
+    StructuralHashBuilder hash(Literal::KIND);
+    hash.add(static_cast<std::uint64_t>(node.literalKind));
+    switch (node.literalKind) {
+        case LiteralKind::Integer:
+            hash.add(static_cast<std::uint64_t>(node.number.integer));
+            break;
+        case LiteralKind::Float:
+            hash.add(std::bit_cast<std::uint64_t>(node.number.floating));
+            break;
+        case LiteralKind::Char:
+        case LiteralKind::String:
+            hash.add(node.value);
+            break;
+    }
+    StructuralHashBuilder binding = hash;
+    finishExpression(node, hash, binding);
+}
+
+void StructuralHashes::Builder::leaveReference(Reference &node) {
+    StructuralHashBuilder hash(Reference::KIND);
+    hash.add(node.name);
+    hash.add(static_cast<std::uint64_t>(node.isReference));
+
+    // an unresolved reference could name any variable of that name, it is only equal to itself
+    StructuralHashBuilder binding(Reference::KIND);
+    if (node.slot != INVALID_SLOT) {
+        binding.add(node.slot);
+    } else {
+        binding.add(reinterpret_cast<std::uintptr_t>(&node));
+    }
+    binding.add(static_cast<std::uint64_t>(node.isReference));
+    finishExpression(node, hash, binding);
+}
+
+void StructuralHashes::Builder::leaveBinaryOperation(BinaryOperation &node) {
+    StructuralHashBuilder hash(BinaryOperation::KIND);
+    hash.add(static_cast<std::uint64_t>(node.operatorKind));
+    StructuralHashBuilder binding = hash;
+    finishExpression(node, hash, binding);
+}
+
+void StructuralHashes::Builder::leaveUnaryOperation(UnaryOperation &node) {
+    StructuralHashBuilder hash(UnaryOperation::KIND);
+    hash.add(static_cast<std::uint64_t>(node.operatorKind));
+    StructuralHashBuilder binding = hash;
+    finishExpression(node, hash, binding);
+}
+
+void StructuralHashes::Builder::leaveIfStatement(IfStatement &node) {
+    StructuralHashBuilder hash(IfStatement::KIND);
+    finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveWhileLoop(WhileLoop &node) {
+    StructuralHashBuilder hash(WhileLoop::KIND);
+    finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveReturnStatement(ReturnStatement &node) {
+    StructuralHashBuilder hash(ReturnStatement::KIND);
+    finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveExpressionStatement(ExpressionStatement &node) {
+    StructuralHashBuilder hash(ExpressionStatement::KIND);
+    finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveAssignment(Assignment &node) {
+    StructuralHashBuilder hash(Assignment::KIND);
+    hash.add(node.name);
+    hash.add(static_cast<std::uint64_t>(node.isPointerDereference));
+    finish(node, hash);
+}
+
+void StructuralHashes::Builder::leaveError(ErrorNode &node) {
+    // the message but not the offset, positions are left out
+    StructuralHashBuilder hash(ErrorNode::KIND);
+    hash.add(node.message);
+    finish(node, hash);
+}
@@ -1,148 +1,572 @@
 #include "../include/Tokenizer.h"
 
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <exception>
 #include <iostream>
-#include <set>
+#include <memory>
+#include <ranges>
 #include <stdexcept>
+#include <thread>
 
-Tokenizer::Tokenizer(const std::string &filepath) : m_filepath(filepath) {}
+#include "../include/Scanner.h"
 
-auto Tokenizer::tokenize() -> std::vector<Token> {
-    m_source = readSource();
-    m_line = 1;
-    m_column = 1;
-    m_max_index = m_source.size();
-    m_current_index = 0;
+namespace {
+    // Character classes driving the lexer state machine
+    enum class CharClass : std::uint8_t { Invalid, Whitespace, Newline, Letter, Digit, Quote, Symbol };
 
-    while (m_current_index < m_max_index) {
-        char currentChar = m_source[m_current_index];
-
-        if (WHITESPACE.contains(currentChar)) {
-            handleWhiteSpace();
-        } else if (isalpha(currentChar) || currentChar == '_') {
-            handleIdentifierOrKeyword();
-        } else if (isdigit(currentChar)) {
-            handleNumber();
-        } else if (currentChar == '"' || currentChar == '\'') {
-            handleStringOrChar();
-        } else if (SYMBOLS.contains(currentChar)) {
-            handleSymbol();
-        } else {
-            throwError("Tokenizer: invalid character");
+    constexpr std::string_view SYMBOL_CHARACTERS = "+-*/%=!<>&|^~(){}[];,.:?@#$\\`";
+
+    constexpr auto CHAR_CLASSES = [] {
+        std::array<CharClass, 256> table{};
+        for (const char c : std::string_view(" \t\r\0", 4)) {
+            table[static_cast<unsigned char>(c)] = CharClass::Whitespace;
+        }
+        table['\n'] = CharClass::Newline;
+        for (unsigned char c = 'a'; c <= 'z'; ++c) {
+            table[c] = CharClass::Letter;
+            table[c - 'a' + 'A'] = CharClass::Letter;
+        }
+        table['_'] = CharClass::Letter;
+        for (unsigned char c = '0'; c <= '9'; ++c) {
+            table[c] = CharClass::Digit;
+        }
+        table['"'] = CharClass::Quote;
+        table['\''] = CharClass::Quote;
+        for (const char c : SYMBOL_CHARACTERS) {
+            table[static_cast<unsigned char>(c)] = CharClass::Symbol;
+        }
+        return table;
+    }();
+
+    // Token kind of every single character symbol, a symbol character missing from OPERATORS fails the build
+    constexpr auto SYMBOL_KINDS = [] {
+        std::array<TokenKind, 256> table{};
+        for (const char c : SYMBOL_CHARACTERS) {
+            table[static_cast<unsigned char>(c)] = lookupOperator(std::string_view(&c, 1)).value();
+        }
+        return table;
+    }();
+
+    // Quoted literals exclude the quotes from the token value, but the lexer consumes them as part of the token
+    constexpr auto isQuoted(const TokenKind kind) -> bool {
+        return kind == TokenKind::String || kind == TokenKind::Char;
+    }
+
+    auto lexicalStart(const TokenKind kind, const std::uint32_t offset) -> std::int64_t {
+        return static_cast<std::int64_t>(offset) - (isQuoted(kind) ? 1 : 0);
+    }
+
+    auto lexicalEnd(const TokenStore &tokens, const std::size_t index) -> std::int64_t {
+        return static_cast<std::int64_t>(tokens.getOffset(index)) + tokens.getLength(index) +
+               (isQuoted(tokens.getKind(index)) ? 1 : 0);
+    }
+
+    // Tokens of one chunk of the source, lexed speculatively on a worker thread with a private interner
+    struct Chunk {
+        std::size_t                     begin = 0;
+        std::size_t                     end = 0;
+        std::size_t                     lexedUntil = 0;  // end of the last token, at least the chunk end
+        std::size_t                     symbolCount = 0; // symbols interned for the kept tokens
+        std::unique_ptr<StringInterner> interner = std::make_unique<StringInterner>();
+        std::optional<TokenStore>       tokens;
+        std::exception_ptr              error;
+    };
+
+    // Run of tokens [first, last) of a store that ends up at index in the stitched stream
+    struct Segment {
+        const TokenStore     *tokens = nullptr;
+        std::size_t           first = 0;
+        std::size_t           last = 0;
+        std::vector<SymbolId> symbols{}; // SymbolId of the shared interner per id of the store, empty if shared already
+        std::size_t           index = 0;
+        std::size_t           numberIndex = 0; // of the number entries of the run in the stitched stream
+    };
+
+    constexpr auto classOf(const char c) -> CharClass { return CHAR_CLASSES[static_cast<unsigned char>(c)]; }
+
+    // Base of a 0x or 0b prefix a number starts with, 10 without one
+    constexpr auto baseOf(const std::string_view spelling) -> int {
+        if (spelling.size() < 2 || spelling[0] != '0') {
+            return 10;
+        }
+        switch (spelling[1]) {
+            case 'x':
+            case 'X':
+                return 16;
+            case 'b':
+            case 'B':
+                return 2;
+            default:
+                return 10;
+        }
+    }
+
+    constexpr auto isDigitOf(const char c, const int base) -> bool {
+        return base == 16 ? classOf(c) == CharClass::Digit || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+                          : classOf(c) == CharClass::Digit;
+    }
+
+    // Whether a decimal float that std::from_chars found out of range is too small for a double rather than too large.
+    // Only a number below 1 can round to zero and only one above 1 can overflow, the decimal exponent of the leading
+    // nonzero digit tells them apart.
+    auto isUnderflow(const std::string_view spelling) -> bool {
+        const std::size_t      exponentStart = spelling.find_first_of("eE");
+        const std::string_view mantissa = spelling.substr(0, exponentStart);
+        const std::size_t      period = std::min(mantissa.find('.'), mantissa.size());
+        const std::size_t      leading = mantissa.find_first_not_of("0.");
+        if (leading == std::string_view::npos) {
+            return true;
         }
+        std::int64_t exponent = leading < period ? static_cast<std::int64_t>(period - leading) - 1
+                                                 : -static_cast<std::int64_t>(leading - period);
+
+        if (exponentStart != std::string_view::npos) {
+            std::string_view written = spelling.substr(exponentStart + 1);
+            const bool       negative = written.starts_with('-');
+            if (written.starts_with('-') || written.starts_with('+')) {
+                written.remove_prefix(1);
+            }
+            std::int32_t magnitude = 0;
+            if (std::from_chars(written.data(), written.data() + written.size(), magnitude).ec != std::errc()) {
+                return negative; // beyond any number of mantissa digits
+            }
+            exponent += negative ? -static_cast<std::int64_t>(magnitude) : magnitude;
+        }
+        return exponent < 0;
     }
 
-    return m_tokens;
+    // Converts the spelling of a number with std::from_chars, returns the error message if it is malformed or does
+    // not fit the value. Decimal numbers with a period or an exponent are Float, any other number is Integer.
+    auto convertNumber(std::string_view spelling, TokenKind &kind, NumberValue &value) -> std::string_view {
+        const int base = baseOf(spelling);
+        if (base != 10) {
+            spelling.remove_prefix(2);
+        }
+
+        // a digit separator '_' has to stand between two digits and is dropped before the conversion
+        std::string digits;
+        if (spelling.find('_') != std::string_view::npos) {
+            for (std::size_t index = 0; index < spelling.size(); ++index) {
+                if (spelling[index] != '_') {
+                    digits += spelling[index];
+                } else if (index == 0 || index + 1 == spelling.size() || !isDigitOf(spelling[index - 1], base) ||
+                           !isDigitOf(spelling[index + 1], base)) {
+                    return "misplaced digit separator";
+                }
+            }
+            spelling = digits;
+        }
+        if (spelling.empty()) {
+            return "missing digits after base prefix";
+        }
+
+        const char *first = spelling.data();
+        const char *last = first + spelling.size();
+        if (base == 10 && spelling.find_first_of(".eE") != std::string_view::npos) {
+            if (const std::size_t period = spelling.find('.'); period != std::string_view::npos) {
+                if (period + 1 == spelling.size() || classOf(spelling[period + 1]) != CharClass::Digit) {
+                    return "invalid float format"; // a period has to be followed by a digit
+                }
+                if (spelling.find('.', period + 1) != std::string_view::npos) {
+                    return "multiple periods in float";
+                }
+            }
+            kind = TokenKind::Float;
+            const auto [end, error] = std::from_chars(first, last, value.floating);
+            if (error == std::errc::result_out_of_range) {
+                // underflow rounds to zero like in C and C++, denormals are converted without an error
+                if (!isUnderflow(std::string_view(first, end))) {
+                    return "float literal out of range";
+                }
+                value.floating = 0.0;
+                return end != last ? "invalid float format" : std::string_view();
+            }
+            return error != std::errc() || end != last ? "invalid float format" : std::string_view();
+        }
+
+        kind = TokenKind::Integer;
+        const auto [end, error] = std::from_chars(first, last, value.integer, base);
+        if (error == std::errc::result_out_of_range) {
+            return "integer literal out of range";
+        }
+        return error != std::errc() || end != last ? "invalid digit in number" : std::string_view();
+    }
+} // namespace
+
+Tokenizer::Tokenizer(const SourceBuffer &source, StringInterner &interner, Diagnostics *diagnostics) :
+    m_sourceBuffer(&source), m_source(source.getText()), m_interner(&interner), m_diagnostics(diagnostics),
+    m_max_index(m_source.size()) {}
+
+auto Tokenizer::peek(const std::size_t k) -> const Token & {
+    if (k >= LOOKAHEAD) {
+        throw std::out_of_range("Tokenizer: lookahead of " + std::to_string(k) + " exceeds the ring buffer");
+    }
+    while (m_lookahead_count <= k) {
+        m_lookahead[(m_lookahead_start + m_lookahead_count) % LOOKAHEAD] = lexToken();
+        m_lookahead_count++;
+    }
+    return m_lookahead[(m_lookahead_start + k) % LOOKAHEAD];
 }
 
-void Tokenizer::handleWhiteSpace() {
-    while (m_current_index < m_max_index && WHITESPACE.contains(m_source[m_current_index])) {
-        if (m_source[m_current_index] == '\n') {
-            m_line++;
-            m_column = 1;
-        } else {
-            m_column++;
+auto Tokenizer::next() -> Token {
+    Token token = peek();
+    m_lookahead_start = (m_lookahead_start + 1) % LOOKAHEAD;
+    m_lookahead_count--;
+    return token;
+}
+
+auto Tokenizer::tokenize() -> TokenStore {
+    TokenStore tokens(*m_sourceBuffer, *m_interner);
+    tokens.reserve((m_max_index - m_current_index) / 4); // typical source averages a token every few bytes
+    for (Token token = next(); token.getKind() != TokenKind::EndOfFile; token = next()) {
+        tokens.push(token);
+    }
+    return tokens;
+}
+
+auto Tokenizer::relex(TokenStore &tokens, const SourceBuffer &source, StringInterner &interner, const SourceEdit &edit)
+        -> TokenRange {
+    if (&tokens.getInterner() != &interner) {
+        throw std::invalid_argument("Tokenizer: relex needs the interner the tokens were lexed with");
+    }
+    const std::int64_t editEnd = static_cast<std::int64_t>(edit.offset) + edit.replacement.size();
+    if (editEnd > static_cast<std::int64_t>(source.size())) {
+        throw std::invalid_argument("Tokenizer: edit lies outside of the edited source");
+    }
+    const std::int64_t delta = static_cast<std::int64_t>(edit.replacement.size()) - edit.length;
+
+    // The first token the edit can touch is the first one ending at or after it, a token ending right at the edit
+    // can still grow (an identifier gaining characters, "=" becoming "=="). Everything before that token was lexed
+    // from unchanged text, so the lexer restarts at the end of the token preceding it.
+    const std::size_t begin = *std::ranges::partition_point(std::views::iota(std::size_t{0}, tokens.size()),
+                                                            [&](const std::size_t index) {
+                                                                return lexicalEnd(tokens, index) < edit.offset;
+                                                            });
+
+    Tokenizer tokenizer(source, interner);
+    tokenizer.m_current_index = begin == 0 ? 0 : lexicalEnd(tokens, begin - 1);
+
+    // Once a token starts behind the edit at the shifted start of an old token of the same kind, both lexers see the
+    // same text from there on and produce the same tokens, so the rest of the old stream is kept
+    const auto shiftedStart = [&](const std::size_t index) {
+        return lexicalStart(tokens.getKind(index), tokens.getOffset(index)) + delta;
+    };
+
+    std::vector<Token> relexed;
+    std::size_t        oldEnd = begin;
+    for (Token token = tokenizer.lexToken();; token = tokenizer.lexToken()) {
+        if (token.getKind() == TokenKind::EndOfFile) {
+            oldEnd = tokens.size();
+            break;
         }
-        m_current_index++;
+
+        const std::int64_t start = lexicalStart(token.getKind(), token.getOffset());
+        if (start >= editEnd) {
+            while (oldEnd < tokens.size() && shiftedStart(oldEnd) < start) {
+                oldEnd++;
+            }
+            if (oldEnd < tokens.size() && tokens.getKind(oldEnd) == token.getKind() && shiftedStart(oldEnd) == start) {
+                break;
+            }
+        }
+
+        relexed.push_back(token);
     }
+
+    tokens.splice(begin, oldEnd, relexed, delta, source);
+    return {begin, oldEnd, begin + relexed.size()};
 }
 
-void Tokenizer::handleKeyword() {
-    std::string keyword;
-    while (m_current_index < m_max_index && isalpha(m_source[m_current_index])) {
-        keyword += m_source[m_current_index];
-        advance();
+auto Tokenizer::tokenizeParallel(unsigned int threads) -> TokenStore {
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    if (threads == 1 || m_diagnostics != nullptr || m_max_index - m_current_index < 2 * MIN_CHUNK_SIZE) {
+        return tokenize();
+    }
+
+    // Tokens already sitting in the lookahead come first
+    TokenStore prefix(*m_sourceBuffer, *m_interner);
+    while (m_lookahead_count > 0) {
+        if (const Token token = next(); token.getKind() != TokenKind::EndOfFile) {
+            prefix.push(token);
+        }
+    }
+
+    // Split right after newlines: outside of string and char literals the lexer is between tokens there, comments end
+    // at the newline. Whether a newline lies inside a literal is only known once everything before it is lexed.
+    const std::size_t  chunkSize = std::max<std::size_t>(MIN_CHUNK_SIZE, (m_max_index - m_current_index) / threads + 1);
+    std::vector<Chunk> chunks;
+    for (std::size_t begin = m_current_index; begin < m_max_index;) {
+        std::size_t end = m_max_index;
+        if (m_max_index - begin > chunkSize + MIN_CHUNK_SIZE) {
+            const char *newline =
+                    scanner::findLineEnd(m_source.data() + begin + chunkSize, m_source.data() + m_max_index);
+            end = static_cast<std::size_t>(std::min(newline + 1, m_source.data() + m_max_index) - m_source.data());
+        }
+        chunks.emplace_back().begin = begin;
+        chunks.back().end = end;
+        begin = end;
+    }
+
+    {
+        std::vector<std::jthread> workers;
+        for (Chunk &chunk : chunks) {
+            workers.emplace_back([this, &chunk] {
+                Tokenizer tokenizer(*m_sourceBuffer, *chunk.interner);
+                tokenizer.m_current_index = chunk.begin;
+                chunk.tokens.emplace(*m_sourceBuffer, *chunk.interner);
+                chunk.tokens->reserve((chunk.end - chunk.begin) / 4);
+                try {
+                    chunk.lexedUntil = tokenizer.lexChunk(chunk.end, *chunk.tokens, chunk.symbolCount);
+                } catch (...) {
+                    chunk.error = std::current_exception();
+                }
+            });
+        }
+    }
+
+    // Stitch the chunks in source order. A chunk is kept as is if the previous one ended exactly at its start,
+    // otherwise a token (a literal spanning the split) ran into it and the serial lexer takes over from the end of
+    // that token until one of its tokens starts where a token of the chunk starts. From there on both lexers see
+    // the same text in the same state, so the rest of the chunk is kept.
+    std::vector<Segment>                     segments;
+    std::vector<std::unique_ptr<TokenStore>> serialRuns;
+    segments.push_back({&prefix, 0, prefix.size()});
+
+    std::size_t cursor = m_current_index; // the serial lexer is between tokens here
+    for (Chunk &chunk : chunks) {
+        const TokenStore &tokens = *chunk.tokens;
+        std::size_t       first = 0;
+
+        if (cursor != chunk.begin) {
+            TokenStore &run = *serialRuns.emplace_back(std::make_unique<TokenStore>(*m_sourceBuffer, *m_interner));
+            Tokenizer   serial(*m_sourceBuffer, *m_interner);
+            serial.m_current_index = cursor;
+
+            bool synchronized = false;
+            for (Token token = serial.lexToken(); token.getKind() != TokenKind::EndOfFile; token = serial.lexToken()) {
+                const std::int64_t start = lexicalStart(token.getKind(), token.getOffset());
+                if (start >= static_cast<std::int64_t>(chunk.end)) {
+                    break;
+                }
+                while (first < tokens.size() && lexicalStart(tokens.getKind(first), tokens.getOffset(first)) < start) {
+                    first++;
+                }
+                if (first < tokens.size() && tokens.getKind(first) == token.getKind() &&
+                    lexicalStart(tokens.getKind(first), tokens.getOffset(first)) == start) {
+                    synchronized = true;
+                    break;
+                }
+                run.push(token);
+                cursor = serial.m_current_index;
+            }
+            segments.push_back({&run, 0, run.size()});
+
+            if (!synchronized) {
+                cursor = std::max(cursor, chunk.end);
+                continue;
+            }
+        }
+
+        // Everything the chunk lexed from first on is what the serial lexer would produce, errors included
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+
+        // Intern in source order so symbol ids come out as the serial lexer assigns them. The private ids of a chunk
+        // kept whole are already in order of first occurrence.
+        Segment &segment = segments.emplace_back(Segment{&tokens, first, tokens.size()});
+        segment.symbols.assign(chunk.symbolCount, INVALID_SYMBOL);
+        if (first == 0) {
+            for (SymbolId symbol = 0; symbol < chunk.symbolCount; ++symbol) {
+                segment.symbols[symbol] = m_interner->intern(chunk.interner->getSpelling(symbol));
+            }
+        } else {
+            for (std::size_t index = first; index < tokens.size(); ++index) {
+                const SymbolId symbol = tokens.getSymbol(index);
+                if (symbol != INVALID_SYMBOL && segment.symbols[symbol] == INVALID_SYMBOL) {
+                    segment.symbols[symbol] = m_interner->intern(chunk.interner->getSpelling(symbol));
+                }
+            }
+        }
+        cursor = chunk.lexedUntil;
+    }
+
+    std::size_t count = 0;
+    std::size_t numberCount = 0;
+    for (Segment &segment : segments) {
+        segment.index = count;
+        segment.numberIndex = numberCount;
+        count += segment.last - segment.first;
+        numberCount += segment.tokens->countNumbers(segment.first, segment.last);
+    }
+
+    TokenStore result(*m_sourceBuffer, *m_interner);
+    result.resize(count, numberCount);
+    {
+        std::vector<std::jthread> copies;
+        for (const Segment &segment : segments) {
+            copies.emplace_back([&result, &segment] {
+                result.copy(segment.index, segment.numberIndex, *segment.tokens, segment.first, segment.last,
+                            segment.symbols);
+            });
+        }
     }
-    addToken(TokenType::Keyword, keyword);
+
+    m_current_index = m_max_index;
+    return result;
 }
 
-void Tokenizer::handleSymbol() {
-    if (m_current_index + 1 < m_max_index) {
-        const std::string symbol = m_source.substr(m_current_index, 2);
+// Lexes the tokens starting before end into tokens, returns where the last of them ends (at least end).
+// symbolCount is the size of the interner after the last kept token.
+auto Tokenizer::lexChunk(const std::size_t end, TokenStore &tokens, std::size_t &symbolCount) -> std::size_t {
+    std::size_t lexedUntil = end;
+    for (Token token = lexToken(); token.getKind() != TokenKind::EndOfFile &&
+                                   lexicalStart(token.getKind(), token.getOffset()) < static_cast<std::int64_t>(end);
+         token = lexToken()) {
+        tokens.push(token);
+        symbolCount = m_interner->size();
+        lexedUntil = std::max(lexedUntil, static_cast<std::size_t>(m_current_index));
+    }
+    return lexedUntil;
+}
 
-        if (symbol == "//") {
-            while (m_current_index < m_max_index && m_source[m_current_index] != '\n') {
-                advance();
+// Skips whitespace and comments and lexes a single token, EndOfFile once the source is exhausted
+auto Tokenizer::lexToken() -> Token {
+    while (m_current_index < m_max_index) {
+        switch (classOf(m_source[m_current_index])) {
+            case CharClass::Whitespace:
+            case CharClass::Newline:
+                handleWhiteSpace();
+                break;
+            case CharClass::Letter:
+                return handleIdentifierOrKeyword();
+            case CharClass::Digit:
+                if (std::optional<Token> token = handleNumber()) {
+                    return *token;
+                }
+                break;
+            case CharClass::Quote:
+                if (std::optional<Token> token = handleStringOrChar()) {
+                    return *token;
+                }
+                break;
+            case CharClass::Symbol:
+                if (m_source[m_current_index] == '/' && m_current_index + 1 < m_max_index &&
+                    m_source[m_current_index + 1] == '/') {
+                    handleComment();
+                    break;
+                }
+                return handleSymbol();
+            case CharClass::Invalid: {
+                const std::size_t start = m_current_index;
+                while (m_current_index < m_max_index && classOf(m_source[m_current_index]) == CharClass::Invalid) {
+                    m_current_index++;
+                }
+                reportError("invalid character", start, m_current_index);
+                break;
             }
-            return;
         }
+    }
 
-        if (LONG_SYMBOLS.contains(symbol)) {
-            addToken(TokenType::Symbol, symbol);
+    return {std::string_view(), TokenKind::EndOfFile, static_cast<std::uint32_t>(m_max_index)};
+}
+
+void Tokenizer::handleWhiteSpace() {
+    advanceTo(scanner::skipWhitespace(m_source.data() + m_current_index, m_source.data() + m_max_index));
+}
+
+void Tokenizer::handleComment() {
+    advanceTo(scanner::findLineEnd(m_source.data() + m_current_index, m_source.data() + m_max_index));
+}
+
+auto Tokenizer::handleSymbol() -> Token {
+    const std::size_t start = m_current_index;
+    const char        first = m_source[m_current_index];
+
+    if (m_current_index + 1 < m_max_index) {
+        if (const std::optional<TokenKind> kind = lookupOperator(m_source.substr(m_current_index, 2))) {
             advance();
             advance();
-            return;
+            return makeToken(*kind, start);
         }
     }
 
-    std::string symbol(1, m_source[m_current_index]);
-    addToken(TokenType::Symbol, symbol);
     advance();
+    return makeToken(SYMBOL_KINDS[static_cast<unsigned char>(first)], start);
 }
 
-void Tokenizer::handleStringOrChar() {
-    std::string value;
-    const char  quote = m_source[m_current_index];
+auto Tokenizer::handleStringOrChar() -> std::optional<Token> {
+    const std::size_t literalStart = m_current_index;
+    const char        quote = m_source[m_current_index];
     advance();
 
+    // the token value excludes the quotes
+    const std::size_t start = m_current_index;
     while (m_current_index < m_max_index && m_source[m_current_index] != quote) {
-        value += m_source[m_current_index];
         advance();
     }
+    const std::size_t length = m_current_index - start;
 
     if (m_current_index >= m_max_index) {
-        throwError("Tokenizer: unterminated string or char literal");
+        // most likely the closing quote is missing on the line the literal starts on, resume lexing after that line
+        const char *lineEnd = scanner::findLineEnd(m_source.data() + start, m_source.data() + m_max_index);
+        reportError("unterminated string or char literal", literalStart, lineEnd - m_source.data());
+        advanceTo(lineEnd);
+        return std::nullopt;
     }
 
     advance(); // Consume the closing quote
 
     if (quote == '"') {
-        addToken(TokenType::String, value);
-    } else {
-        if (value.size() != 1) {
-            throwError("Tokenizer: invalid char");
-        }
-        addToken(TokenType::Char, value);
+        return makeToken(TokenKind::String, start, length);
     }
+    if (length != 1) {
+        reportError("invalid char", literalStart, m_current_index);
+        return std::nullopt;
+    }
+    return makeToken(TokenKind::Char, start, length);
 }
 
-void Tokenizer::handleNumber() {
-    std::string number;
-    bool        isFloat = false;
-
-    while (m_current_index < m_max_index && (isdigit(m_source[m_current_index]) || m_source[m_current_index] == '.')) {
-        if (m_source[m_current_index] == '.') {
-            if (isFloat) {
-                throwError("Tokenizer: multiple periods in float");
-            }
-            isFloat = true;
+auto Tokenizer::handleNumber() -> std::optional<Token> {
+    const std::size_t start = m_current_index;
+    const bool        decimal = baseOf(m_source.substr(start, 2)) == 10;
 
-            // Check if there's a digit after the '.'
-            if (m_current_index + 1 >= m_max_index || !isdigit(m_source[m_current_index + 1])) {
-                throwError("Tokenizer: invalid float format");
-            }
+    // A number runs over digits, letters, '_' and periods and the sign of a decimal exponent, it is converted once
+    // it is complete. A malformed number is consumed as a whole so lexing resumes after it.
+    while (m_current_index < m_max_index) {
+        const char c = m_source[m_current_index];
+        const bool exponentSign = (c == '+' || c == '-') && decimal && (m_source[m_current_index - 1] | 0x20) == 'e';
+        if (classOf(c) != CharClass::Digit && classOf(c) != CharClass::Letter && c != '.' && !exponentSign) {
+            break;
         }
-
-        number += m_source[m_current_index];
-        advance();
+        m_current_index++;
     }
 
-    addToken(isFloat ? TokenType::Float : TokenType::Integer, number);
+    const std::string_view spelling = m_source.substr(start, m_current_index - start);
+    TokenKind              kind = TokenKind::Integer;
+    NumberValue            value;
+    if (const std::string_view error = convertNumber(spelling, kind, value); !error.empty()) {
+        reportError(error, start, m_current_index);
+        return std::nullopt;
+    }
+    return Token(spelling, kind, static_cast<std::uint32_t>(start), value);
 }
 
-void Tokenizer::handleIdentifierOrKeyword() {
-    std::string identifier;
+auto Tokenizer::handleIdentifierOrKeyword() -> Token {
+    const std::size_t start = m_current_index;
 
-    while (m_current_index < m_max_index && (isalnum(m_source[m_current_index]) || m_source[m_current_index] == '_')) {
-        identifier += m_source[m_current_index];
-        advance();
-    }
+    advanceTo(scanner::skipIdentifier(m_source.data() + m_current_index, m_source.data() + m_max_index));
 
-    if (KEYWORDS.contains(identifier)) {
-        addToken(TokenType::Keyword, identifier);
-    } else {
-        addToken(TokenType::Identifier, identifier);
+    const std::string_view spelling = m_source.substr(start, m_current_index - start);
+    if (const std::optional<TokenKind> keyword = lookupKeyword(spelling)) {
+        return makeToken(*keyword, start);
     }
+
+    return {spelling, TokenKind::Identifier, static_cast<std::uint32_t>(start), m_interner->intern(spelling)};
 }
 
 void Tokenizer::advance() {
@@ -150,36 +574,207 @@ void Tokenizer::advance() {
         throwError("Tokenizer: cannot advance past end of source");
     }
     m_current_index++;
-    m_column++;
 }
 
-void Tokenizer::addToken(TokenType type, const std::string &value) {
-    m_tokens.emplace_back(value, type, Position(m_line, m_column));
+void Tokenizer::advanceTo(const char *position) {
+    m_current_index = static_cast<std::size_t>(position - m_source.data());
+}
+
+// Makes a token spanning from start up to the current index
+auto Tokenizer::makeToken(const TokenKind kind, const std::size_t start) const -> Token {
+    return makeToken(kind, start, m_current_index - start);
+}
+
+auto Tokenizer::makeToken(const TokenKind kind, const std::size_t start, const std::size_t length) const -> Token {
+    return {m_source.substr(start, length), kind, static_cast<std::uint32_t>(start)};
+}
+
+// Records a lexical error spanning [start, end), without a diagnostics sink it is thrown as a TokenizerError instead
+void Tokenizer::reportError(const std::string_view message, const std::size_t start, const std::size_t end) {
+    if (m_diagnostics == nullptr) {
+        m_current_index = start;
+        throwError("Tokenizer: " + std::string(message));
+    }
+    m_diagnostics->error({static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(end - start)}, message);
 }
 
 void Tokenizer::throwError(const std::string &message) const {
-    throw std::runtime_error(message + " at line " + std::to_string(m_line) + " column " + std::to_string(m_column) +
-                             " (character: " +
+    const Position position = m_sourceBuffer->getPosition(static_cast<std::uint32_t>(m_current_index));
+    throw TokenizerError(message + " at line " + std::to_string(position.getLine()) + " column " +
+                         std::to_string(position.getColumn()) + " (character: " +
                              (m_current_index < m_max_index ? std::string(1, m_source[m_current_index]) : "EOF") + ")");
 }
 
-auto Tokenizer::readSource() const -> std::string {
-    std::ifstream file(m_filepath);
-    std::string   source;
+Token::Token(const std::string_view value, const TokenKind kind, const std::uint32_t offset, const SymbolId symbol) :
+    m_kind(kind), m_offset(offset), m_symbol(symbol), m_value(value) {}
 
-    if (file.is_open()) {
-        std::string line;
-        while (std::getline(file, line)) {
-            source += line + '\n';
-        }
+Token::Token(const std::string_view value, const TokenKind kind, const std::uint32_t offset, const NumberValue number) :
+    m_kind(kind), m_offset(offset), m_number(number), m_value(value) {}
+
+TokenStore::TokenStore(const SourceBuffer &source, const StringInterner &interner) :
+    m_source(&source), m_interner(&interner) {}
+
+void TokenStore::push(const Token &token) {
+    m_kinds.push_back(token.getKind());
+    m_offsets.push_back(token.getOffset());
+    if (isNumberKind(token.getKind())) {
+        m_payloads.push_back(static_cast<std::uint32_t>(m_numbers.size()));
+        m_numbers.push_back({token.getNumber(), static_cast<std::uint32_t>(token.getValue().size())});
     } else {
-        throw std::runtime_error("Failed to open file");
+        m_payloads.push_back(token.getKind() == TokenKind::Identifier
+                                     ? token.getSymbol()
+                                     : static_cast<std::uint32_t>(token.getValue().size()));
     }
+}
 
-    return source;
+void TokenStore::reserve(const std::size_t count) {
+    m_kinds.reserve(count);
+    m_offsets.reserve(count);
+    m_payloads.reserve(count);
 }
 
-Token::Token(std::string value, const TokenType type, const Position position) :
-    m_type(type), m_value(std::move(value)), m_position(position) {}
+auto TokenStore::getValue(const std::size_t index) const -> std::string_view {
+    if (index >= size()) {
+        return {};
+    }
+    return m_source->getText().substr(m_offsets[index], getLength(index));
+}
 
-Position::Position(const unsigned int line, const unsigned int column) : m_line(line), m_column(column) {}
+auto TokenStore::getLength(const std::size_t index) const -> std::uint32_t {
+    if (index >= size()) {
+        return 0;
+    }
+    if (m_kinds[index] == TokenKind::Identifier) {
+        return static_cast<std::uint32_t>(m_interner->getSpelling(m_payloads[index]).size());
+    }
+    return isNumberKind(m_kinds[index]) ? m_numbers[m_payloads[index]].length : m_payloads[index];
+}
+
+void TokenStore::resize(const std::size_t count, const std::size_t numberCount) {
+    m_kinds.resize(count);
+    m_offsets.resize(count);
+    m_payloads.resize(count);
+    m_numbers.resize(numberCount);
+}
+
+void TokenStore::copy(const std::size_t index, const std::size_t numberIndex, const TokenStore &other,
+                      const std::size_t first, const std::size_t last, const std::span<const SymbolId> symbols) {
+    const auto from = static_cast<std::ptrdiff_t>(first);
+    const auto to = static_cast<std::ptrdiff_t>(last);
+    const auto at = static_cast<std::ptrdiff_t>(index);
+    std::copy(other.m_kinds.begin() + from, other.m_kinds.begin() + to, m_kinds.begin() + at);
+    std::copy(other.m_offsets.begin() + from, other.m_offsets.begin() + to, m_offsets.begin() + at);
+    std::size_t number = numberIndex;
+    for (std::size_t source = first, target = index; source < last; ++source, ++target) {
+        const std::uint32_t payload = other.m_payloads[source];
+        if (isNumberKind(other.m_kinds[source])) {
+            m_numbers[number] = other.m_numbers[payload];
+            m_payloads[target] = static_cast<std::uint32_t>(number++);
+        } else if (other.m_kinds[source] == TokenKind::Identifier && !symbols.empty()) {
+            m_payloads[target] = symbols[payload];
+        } else {
+            m_payloads[target] = payload;
+        }
+    }
+}
+
+auto TokenStore::countNumbers(const std::size_t first, const std::size_t last) const -> std::size_t {
+    return static_cast<std::size_t>(std::count_if(m_kinds.begin() + static_cast<std::ptrdiff_t>(first),
+                                                  m_kinds.begin() + static_cast<std::ptrdiff_t>(last), isNumberKind));
+}
+
+auto TokenStore::numberIndex(std::size_t index) const -> std::size_t {
+    for (; index < size(); ++index) {
+        if (isNumberKind(m_kinds[index])) {
+            return m_payloads[index];
+        }
+    }
+    return m_numbers.size();
+}
+
+void TokenStore::splice(const std::size_t begin, const std::size_t end, const std::vector<Token> &tokens,
+                        const std::int64_t delta, const SourceBuffer &source) {
+    // the number entries of the replaced tokens are replaced as well, so the entries stay in token order
+    const std::size_t numbersBegin = numberIndex(begin);
+    const std::size_t numbersEnd = numberIndex(end);
+
+    std::vector<TokenKind>     kinds;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> payloads;
+    std::vector<NumberEntry>   numbers;
+    kinds.reserve(tokens.size());
+    offsets.reserve(tokens.size());
+    payloads.reserve(tokens.size());
+    for (const Token &token : tokens) {
+        kinds.push_back(token.getKind());
+        offsets.push_back(token.getOffset());
+        if (isNumberKind(token.getKind())) {
+            payloads.push_back(static_cast<std::uint32_t>(numbersBegin + numbers.size()));
+            numbers.push_back({token.getNumber(), static_cast<std::uint32_t>(token.getValue().size())});
+        } else {
+            payloads.push_back(token.getKind() == TokenKind::Identifier
+                                       ? token.getSymbol()
+                                       : static_cast<std::uint32_t>(token.getValue().size()));
+        }
+    }
+
+    const auto numberDelta = static_cast<std::int64_t>(numbers.size()) -
+                             static_cast<std::int64_t>(numbersEnd - numbersBegin);
+    for (std::size_t index = end; index < size(); ++index) {
+        m_offsets[index] = static_cast<std::uint32_t>(m_offsets[index] + delta);
+        if (isNumberKind(m_kinds[index])) {
+            m_payloads[index] = static_cast<std::uint32_t>(m_payloads[index] + numberDelta);
+        }
+    }
+
+    const auto first = static_cast<std::ptrdiff_t>(begin);
+    const auto last = static_cast<std::ptrdiff_t>(end);
+    m_kinds.erase(m_kinds.begin() + first, m_kinds.begin() + last);
+    m_kinds.insert(m_kinds.begin() + first, kinds.begin(), kinds.end());
+    m_offsets.erase(m_offsets.begin() + first, m_offsets.begin() + last);
+    m_offsets.insert(m_offsets.begin() + first, offsets.begin(), offsets.end());
+    m_payloads.erase(m_payloads.begin() + first, m_payloads.begin() + last);
+    m_payloads.insert(m_payloads.begin() + first, payloads.begin(), payloads.end());
+    m_numbers.erase(m_numbers.begin() + static_cast<std::ptrdiff_t>(numbersBegin),
+                    m_numbers.begin() + static_cast<std::ptrdiff_t>(numbersEnd));
+    m_numbers.insert(m_numbers.begin() + static_cast<std::ptrdiff_t>(numbersBegin), numbers.begin(), numbers.end());
+
+    m_source = &source;
+}
+
+auto TokenStore::operator[](const std::size_t index) const -> Token {
+    if (isNumberKind(getKind(index))) {
+        return {getValue(index), getKind(index), getOffset(index), getNumber(index)};
+    }
+    return {getValue(index), getKind(index), getOffset(index), getSymbol(index)};
+}
+
+TokenStoreStream::TokenStoreStream(const TokenStore &tokens) : m_tokens(&tokens), m_end(tokens.size()) {}
+
+TokenStoreStream::TokenStoreStream(const TokenStore &tokens, const std::size_t begin, const std::size_t end) :
+    m_tokens(&tokens), m_current_index(begin), m_end(std::min(end, tokens.size())) {}
+
+auto TokenStoreStream::peek(const std::size_t k) -> const Token & {
+    if (k >= WINDOW) {
+        throw std::out_of_range("TokenStoreStream: lookahead of " + std::to_string(k) + " exceeds the window");
+    }
+    // every token is materialized once when it enters the window, however often it is peeked at
+    while (m_window_count <= k) {
+        const std::size_t index = m_current_index + m_window_count;
+        m_window[(m_window_start + m_window_count) % WINDOW] =
+                index < m_end ? (*m_tokens)[index]
+                              : Token({}, TokenKind::EndOfFile, m_tokens->getOffset(m_end), INVALID_SYMBOL);
+        m_window_count++;
+    }
+    return m_window[(m_window_start + k) % WINDOW];
+}
+
+auto TokenStoreStream::next() -> Token {
+    Token token = peek();
+    if (m_current_index < m_end) {
+        m_current_index++;
+        m_window_start = (m_window_start + 1) % WINDOW;
+        m_window_count--;
+    }
+    return token;
+}
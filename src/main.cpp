@@ -6,24 +6,51 @@
 #include <vector>
 
 #include "../include/CodeGenerator.h"
+#include "../include/Diagnostics.h"
+#include "../include/FlatAst.h"
 #include "../include/Parser.h"
+#include "../include/Resolver.h"
+#include "../include/SourceBuffer.h"
+#include "../include/StringInterner.h"
 #include "../include/Tokenizer.h"
 
-enum class ExitCode : std::uint8_t { SUCCESS = 0, TOKENIZER_ERROR = 1, PARSER_ERROR = 2, IR_ERROR = 3 };
+enum class ExitCode : std::uint8_t {
+    SUCCESS = 0,
+    TOKENIZER_ERROR = 1,
+    PARSER_ERROR = 2,
+    IR_ERROR = 3,
+    USAGE_ERROR = 4,
+    AST_FILE_ERROR = 5,
+    SEMANTIC_ERROR = 6
+};
+
+// Command line of the driver: [--emit-ast <file>] [--load-ast <file>] [source-file]
+struct Options {
+    std::string sourcePath = "../resources/test.pc";
+    std::string emitAstPath; // write the parsed AST as a .pcast file
+    std::string loadAstPath; // read the AST from a .pcast file instead of lexing and parsing the source
+};
 
 const static std::string NAME = "PCore Compiler";
 const static std::string VERSION = "1.4.0";
 const static std::string AUTHOR = "liamd";
 
-static auto compile(const std::string &filepath) -> ExitCode;
+static auto parseOptions(int argc, char *argv[], Options &options) -> bool;
+static auto compile(const Options &options) -> ExitCode;
+static auto parse(const std::string &filepath, StringInterner &interner, std::unique_ptr<SourceBuffer> &source,
+                  std::unique_ptr<Program> &program) -> ExitCode;
 static void compileLLVMOutputAndRun();
 
 int main(int argc, char *argv[]) {
-    // todo: add command line arguments
-
     std::cout << NAME << " v" << VERSION << " by " << AUTHOR << '\n';
 
-    const ExitCode exitCode = compile("../resources/test.pc");
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0] << " [--emit-ast <file.pcast>] [--load-ast <file.pcast>] [source-file]\n";
+        return static_cast<int>(ExitCode::USAGE_ERROR);
+    }
+
+    const ExitCode exitCode = compile(options);
 
     if (exitCode == ExitCode::SUCCESS) {
         compileLLVMOutputAndRun();
@@ -32,43 +59,73 @@ int main(int argc, char *argv[]) {
     return static_cast<int>(exitCode);
 }
 
-static auto compile(const std::string &filepath) -> ExitCode {
-    std::vector<Token> tokens;
-
-    // Tokenize source code
-    try {
-        Tokenizer tokenizer(filepath);
-        tokens = tokenizer.tokenize();
-
-        // For debugging purposes
-        for (const Token &token : tokens) {
-            token.print();
+static auto parseOptions(const int argc, char *argv[], Options &options) -> bool {
+    bool hasSource = false;
+    for (int index = 1; index < argc; ++index) {
+        const std::string argument = argv[index];
+        if (argument == "--emit-ast" || argument == "--load-ast") {
+            if (index + 1 == argc) {
+                return false;
+            }
+            (argument == "--emit-ast" ? options.emitAstPath : options.loadAstPath) = argv[++index];
+        } else if (!argument.starts_with("-") && !hasSource) {
+            options.sourcePath = argument;
+            hasSource = true;
+        } else {
+            return false;
         }
+    }
+    return true;
+}
 
-        std::cout << "//---------------------- Tokenization successful ----------------------//\n";
-    } catch (const std::runtime_error &e) {
-        std::cerr << "Error: " << e.what() << '\n';
-        return ExitCode::TOKENIZER_ERROR;
+static auto compile(const Options &options) -> ExitCode {
+    // Tokens and AST names refer into the source buffer and the interner, so both outlive every phase below
+    StringInterner                interner;
+    std::unique_ptr<SourceBuffer> source;
+    std::unique_ptr<Program>      program;
+
+    // A cached AST replaces lexing and parsing, it was only written for an error free parse
+    if (options.loadAstPath.empty()) {
+        if (const ExitCode exitCode = parse(options.sourcePath, interner, source, program);
+            exitCode != ExitCode::SUCCESS) {
+            return exitCode;
+        }
+    } else {
+        try {
+            program = FlatAst::load(options.loadAstPath, interner).toProgram();
+        } catch (const std::runtime_error &e) {
+            std::cerr << "Error: " << e.what() << '\n';
+            return ExitCode::AST_FILE_ERROR;
+        }
     }
 
-    // Parse tokens
-    std::unique_ptr<Program> program;
-    try {
-        Parser parser;
-        program = parser.parse(tokens);
+    program->print("");
 
-        program->print("");
+    std::cout << "//---------------------- Parsing successful ----------------------//\n";
+    program->getStatistics().print(std::cout);
 
-        std::cout << "//---------------------- Parsing successful ----------------------//\n";
+    if (!options.emitAstPath.empty()) {
+        try {
+            FlatAst::fromProgram(*program).save(options.emitAstPath);
+        } catch (const std::runtime_error &e) {
+            std::cerr << "Error: " << e.what() << '\n';
+            return ExitCode::AST_FILE_ERROR;
+        }
+    }
+
+    // Bind every name to its declaration
+    Resolution resolution;
+    try {
+        resolution = Resolver::resolve(*program);
     } catch (const std::runtime_error &e) {
         std::cerr << "Error: " << e.what() << '\n';
-        return ExitCode::PARSER_ERROR;
+        return ExitCode::SEMANTIC_ERROR;
     }
 
     // Generate intermediate representation
     try {
         CodeGenerator codeGenerator;
-        codeGenerator.generateCode(program);
+        codeGenerator.generateCode(program, resolution);
 
         std::cout << "//---------------------- IR generation successful ----------------------//\n";
     } catch (const std::runtime_error &e) {
@@ -79,6 +136,39 @@ static auto compile(const std::string &filepath) -> ExitCode {
     return ExitCode::SUCCESS;
 }
 
+static auto parse(const std::string &filepath, StringInterner &interner, std::unique_ptr<SourceBuffer> &source,
+                  std::unique_ptr<Program> &program) -> ExitCode {
+    try {
+        source = std::make_unique<SourceBuffer>(SourceBuffer::fromFile(filepath));
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return ExitCode::TOKENIZER_ERROR;
+    }
+
+    // Tokenize and parse in one pass, the parser pulls tokens from the tokenizer as it needs them.
+    // Lexical and syntax errors are collected rather than thrown, so every one of them is reported in a single run.
+    Diagnostics lexicalDiagnostics(*source);
+    Diagnostics syntaxDiagnostics(*source);
+    try {
+        Tokenizer tokenizer(*source, interner, &lexicalDiagnostics);
+        Parser    parser(&syntaxDiagnostics);
+        program = parser.parse(tokenizer);
+
+        if (lexicalDiagnostics.hasErrors() || syntaxDiagnostics.hasErrors()) {
+            lexicalDiagnostics.print(std::cerr);
+            syntaxDiagnostics.print(std::cerr);
+            return lexicalDiagnostics.hasErrors() ? ExitCode::TOKENIZER_ERROR : ExitCode::PARSER_ERROR;
+        }
+    } catch (const TokenizerError &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return ExitCode::TOKENIZER_ERROR;
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return ExitCode::PARSER_ERROR;
+    }
+    return ExitCode::SUCCESS;
+}
+
 static void compileLLVMOutputAndRun() {
     // Command to execute (compile LLVM IR using llc and clang, run the executable)
     const std::string command = "powershell.exe -Command "
@@ -0,0 +1,109 @@
+// Random edit test of the incremental parser: applies random edits to the literals of a synthetic program, relexes
+// and reparses after each one and checks that
+//  - the reparsed tree prints the same as a full parse of the edited tokens,
+//  - only the edited declaration is replaced, the nodes of all others are the same as before,
+//  - compacting the tree once Parser::compact is due keeps the tree and leaves a single arena.
+//
+// usage: reparse_test [edits] [seed]
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/Parser.h"
+#include "../include/SourceBuffer.h"
+#include "../include/StringInterner.h"
+#include "../include/Tokenizer.h"
+
+namespace {
+    std::size_t failures = 0;
+
+    void check(const bool condition, const std::string &message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << "\n";
+            ++failures;
+        }
+    }
+
+    auto printed(const Program &program) -> std::string {
+        std::ostringstream out;
+        std::streambuf    *previous = std::cout.rdbuf(out.rdbuf());
+        program.print();
+        std::cout.rdbuf(previous);
+        return out.str();
+    }
+
+    auto declarationsOf(const Program &program) -> std::vector<const AbstractNode *> {
+        return {program.body->statements.begin(), program.body->statements.end()};
+    }
+} // namespace
+
+auto main(const int argc, char **argv) -> int {
+    const int          edits = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const unsigned int seed  = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 1;
+
+    std::string text = "program test;\n";
+    for (int index = 0; index < 100; ++index) {
+        text += "(int a) -> int\nfunc f" + std::to_string(index) +
+                " {\n    int b = a * 3 + 1;\n    while b < 100 { b = b + 7; }\n    return b;\n}\n";
+    }
+
+    // the text of each step is released with its buffer, the tree mustn't keep views into older ones
+    StringInterner interner;
+    auto           source  = std::make_unique<SourceBuffer>(SourceBuffer::fromMemory(text));
+    TokenStore     tokens  = Tokenizer(*source, interner).tokenize();
+    auto           program = Parser().parse(tokens);
+
+    std::mt19937 random(seed);
+    std::size_t  compactions = 0;
+    for (int edit = 0; edit < edits; ++edit) {
+        // replace a "3" of a random declaration by an expression that still contains one
+        std::size_t position = text.find("* 3", random() % text.size());
+        if (position == std::string::npos) {
+            position = text.find("* 3");
+        }
+        position += 2;
+        const std::string replacement = "3 + " + std::to_string(random() % 10);
+        std::string       edited      = text.substr(0, position) + replacement + text.substr(position + 1);
+
+        auto             next = std::make_unique<SourceBuffer>(SourceBuffer::fromMemory(edited));
+        const SourceEdit sourceEdit{static_cast<std::uint32_t>(position), 1,
+                                    next->getText().substr(position, replacement.size())};
+        const TokenRange changed = Tokenizer::relex(tokens, *next, interner, sourceEdit);
+        source                   = std::move(next);
+        text                     = std::move(edited); // keeps the characters the new buffer refers to
+
+        const std::vector<const AbstractNode *> before = declarationsOf(*program);
+        program = Parser().reparse(std::move(program), tokens, changed);
+        const std::vector<const AbstractNode *> after = declarationsOf(*program);
+
+        std::size_t replaced = 0;
+        for (std::size_t index = 0; index < before.size() && index < after.size(); ++index) {
+            replaced += before[index] != after[index] ? 1 : 0;
+        }
+        check(before.size() == after.size(), "edit " + std::to_string(edit) + " changed the number of declarations");
+        check(replaced == 1, "edit " + std::to_string(edit) + " replaced " + std::to_string(replaced) +
+                                     " declarations instead of the edited one");
+
+        if (program->needsCompaction()) {
+            const std::string expected = printed(*program);
+            program                    = Parser::compact(*program);
+            ++compactions;
+            check(program->arenas.size() == 1 && program->deadBytes == 0,
+                  "edit " + std::to_string(edit) + ": compaction left dead arenas");
+            check(printed(*program) == expected, "edit " + std::to_string(edit) + ": compaction changed the tree");
+        }
+        if (edit % 100 == 99 || edit == edits - 1) {
+            check(printed(*program) == printed(*Parser().parse(tokens)),
+                  "edit " + std::to_string(edit) + ": reparse differs from a full parse");
+        }
+    }
+    check(edits < 100 || compactions > 0, "no compaction within " + std::to_string(edits) + " edits");
+
+    std::cout << edits << " edits, " << compactions << " compactions, " << failures << " failures\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
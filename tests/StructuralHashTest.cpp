@@ -0,0 +1,92 @@
+// Canonical expressions of StructuralHashes on a resolved program: expressions of equal structure share a canonical
+// node only if their names are bound to the same declarations, while their structural hashes compare names.
+//
+// usage: structural_hash_test
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "../include/Parser.h"
+#include "../include/RecursiveVisitor.h"
+#include "../include/Resolver.h"
+#include "../include/SourceBuffer.h"
+#include "../include/StringInterner.h"
+#include "../include/StructuralHash.h"
+#include "../include/Tokenizer.h"
+
+namespace {
+    std::size_t failures = 0;
+
+    void check(const bool condition, const std::string &message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << "\n";
+            ++failures;
+        }
+    }
+
+    // The initializer of every variable declaration, by the name of the variable
+    class Initializers : public RecursiveVisitor<Initializers> {
+    public:
+        std::map<std::string_view, const AbstractNode *> byName;
+
+        void leaveVariableDeclaration(VariableDeclaration &node) { byName[node.name] = node.initializer; }
+    };
+
+    constexpr std::string_view SOURCE = R"(program test;
+
+(int x) -> int
+first {
+    int a = x + 1;
+    int b = x + 1;
+    if x {
+        int x = 2;
+        int c = x + 1;
+    }
+    return a;
+}
+
+(int x) -> int
+second {
+    int d = x + 1;
+    int e = printf(x) + 1;
+    int f = printf(x) + 1;
+    return d;
+}
+)";
+} // namespace
+
+auto main() -> int {
+    StringInterner                 interner;
+    const SourceBuffer             source = SourceBuffer::fromMemory(SOURCE);
+    const TokenStore               tokens = Tokenizer(source, interner).tokenize();
+    const std::unique_ptr<Program> program = Parser().parse(tokens);
+    Resolver::resolve(*program);
+
+    const StructuralHashes hashes = StructuralHashes::compute(*program);
+    Initializers           initializers;
+    initializers.traverse(*program);
+    const auto &variables = initializers.byName;
+
+    const auto canonicalOf = [&](const std::string_view name) {
+        return hashes.getCanonicalExpression(*variables.at(name));
+    };
+    const auto structureOf = [&](const std::string_view name) {
+        return *hashes.findExpressionHash(*variables.at(name));
+    };
+
+    check(canonicalOf("a") == variables.at("a"), "a is not its own canonical expression");
+    check(canonicalOf("b") == variables.at("a"), "x + 1 twice in one scope isn't canonicalized together");
+    check(canonicalOf("c") == variables.at("c"), "x + 1 of a shadowing x is canonical to the outer one");
+    check(canonicalOf("d") == variables.at("d"), "x + 1 of another function's parameter is canonical to first");
+    check(canonicalOf("f") == variables.at("e"), "calls of a built-in with the same arguments differ");
+
+    check(structureOf("a") == structureOf("c") && structureOf("a") == structureOf("d"),
+          "x + 1 hashes differently across scopes");
+    check(hashes.getDistinctExpressionCount() < hashes.getExpressionCount(), "no expression was canonicalized");
+
+    std::cout << hashes.getExpressionCount() << " expressions, " << hashes.getDistinctExpressionCount()
+              << " distinct, " << failures << " failures\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}